@@ -0,0 +1,85 @@
+// (c) Meta Platforms, Inc. and affiliates. Confidential and proprietary.
+
+// Measures sc_extent_lookup(), the per-call cost checked_memcpy_auto adds on
+// top of checked_memcpy, and fails if it is over the target (5 ns by default,
+// or the first argument). Build and run it with optimizations on, e.g.
+//
+//   cc -O2 -o extent_lookup benchmarks/extent_lookup.c -lpthread
+//   ./extent_lookup
+
+#define _POSIX_C_SOURCE 200809L
+#define SAFEC_EXTENT_REGISTRY
+
+#include "../secure_string_header_only.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BLOCKS 4096
+#define LOOKUPS 4096
+#define TRIALS 4096
+
+static double now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+// Returns the time of one lookup of each pointer, averaged over a pass and
+// taking the fastest of TRIALS passes so that preemption and frequency
+// changes do not count.
+static double lookup_ns(unsigned char* const* pointers, size_t* sink) {
+  double best = 0;
+  for (size_t trial = 0; trial < TRIALS; ++trial) {
+    size_t total = 0;
+    const double start = now_ns();
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+      size_t size = 0;
+      (void)sc_extent_lookup(pointers[i], &size);
+      total += size;
+    }
+    const double elapsed = now_ns() - start;
+    if (trial == 0 || elapsed < best) {
+      best = elapsed;
+    }
+    *sink += total;
+  }
+  return best / LOOKUPS;
+}
+
+int main(int argc, char** argv) {
+  const double target = argc > 1 ? atof(argv[1]) : 5.0;
+  static sc_span blocks[BLOCKS];
+  static unsigned char* bases[LOOKUPS];
+  static unsigned char* interiors[LOOKUPS];
+  uint64_t random = 0x9E3779B97F4A7C15u;
+
+  // Block sizes from 16 bytes to 64 KiB, as a mix of small records and
+  // buffers spanning several pages.
+  for (size_t i = 0; i < BLOCKS; ++i) {
+    random = random * 6364136223846793005u + 1442695040888963407u;
+    blocks[i] = checked_malloc_array((size_t)16 << (random >> 60) % 13, 1);
+  }
+  for (size_t i = 0; i < LOOKUPS; ++i) {
+    random = random * 6364136223846793005u + 1442695040888963407u;
+    const sc_span block = blocks[(random >> 32) % BLOCKS];
+    bases[i] = block.ptr;
+    interiors[i] = block.ptr + (random >> 16) % block.len;
+  }
+
+  size_t sink = 0;
+  const double base_ns = lookup_ns(bases, &sink);
+  const double interior_ns = lookup_ns(interiors, &sink);
+  printf(
+      "sc_extent_lookup: %.2f ns at block bases, %.2f ns at interior "
+      "pointers (target %.2f ns, checksum %zu)\n",
+      base_ns,
+      interior_ns,
+      target,
+      sink);
+
+  for (size_t i = 0; i < BLOCKS; ++i) {
+    checked_free_array(blocks[i]);
+  }
+  return base_ns <= target && interior_ns <= target ? 0 : 1;
+}
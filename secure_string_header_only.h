@@ -2,10 +2,30 @@
 
 #pragma once
 
+// USDT probes are compiled in on ELF targets that the probe notes below know
+// how to describe; see the SAFEC_USDT_PROBE* macros.
+#if !defined(SAFEC_NO_USDT) && !defined(NO_ATTRIBUTE_EXTENSION) && \
+    defined(__linux__) && defined(__ELF__) &&                     \
+    (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#define SAFEC_USDT 1
+#endif
+
+// Vector and CRC intrinsics for the byte-swapping and checksumming copies and
+// the wide fills, also outside of extern "C".
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#include <arm_acle.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,9 +34,50 @@ extern "C" {
 #else
 #include <io.h>
 #endif
+#if defined(SAFEC_STATS) || defined(SAFEC_HEADROOM) || \
+    defined(SAFEC_PROFILE) || defined(SAFEC_TRACE) ||  \
+    defined(SAFEC_GUARDED_ALLOC) || defined(SAFEC_EXTENT_REGISTRY)
+#include <pthread.h>
+#endif
+#if (defined(SAFEC_GUARDED_ALLOC) || defined(SAFEC_PAGE_OPS)) && \
+    !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#endif
+#if defined(SAFEC_FD_COPY) && !defined(_WIN32) && !defined(_WIN64)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+#if defined(SAFEC_EXTENT_REGISTRY) && defined(SAFEC_EXTENT_MALLOC_FALLBACK)
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+#if defined(SAFEC_PROFILE) || defined(SAFEC_TRACE) || \
+    defined(SAFEC_TRACE_REPLAY)
+#include <time.h>
+#endif
 
 #define ERR_POTENTIAL_BUFFER_OVERFLOW 34 // matches with ERANGE in errno.h
 #define ERR_POTENTIAL_INTEGER_OVERFLOW 75 // matches with EOVERFLOW in errno.h
+#define ERR_INVALID_ARGUMENT 22 // matches with EINVAL in errno.h
+#define ERR_OUT_OF_MEMORY 12 // matches with ENOMEM in errno.h
+#define ERR_IO 5 // matches with EIO in errno.h
+
+// Error codes returned by every try_checked_* function (zero on success).
+enum safec_error {
+  SAFEC_OK = 0,
+  SAFEC_ERR_BUFFER_OVERFLOW = ERR_POTENTIAL_BUFFER_OVERFLOW,
+  SAFEC_ERR_INTEGER_OVERFLOW = ERR_POTENTIAL_INTEGER_OVERFLOW,
+  SAFEC_ERR_INVALID_ARGUMENT = ERR_INVALID_ARGUMENT,
+  SAFEC_ERR_OUT_OF_MEMORY = ERR_OUT_OF_MEMORY,
+  SAFEC_ERR_IO = ERR_IO,
+};
 
 #ifdef NO_ATTRIBUTE_EXTENSION
 #define SECURE_LIB_WARN_UNUSED_RESULT
@@ -40,6 +101,109 @@ extern "C" {
 #endif
 #endif
 
+/*
+ * USDT (SystemTap/DTrace style) static probes under the "safec" provider.
+ * Every checked operation fires safec:<api>(count, limit), using the same
+ * count/limit convention as the per-call-site instrumentation below, and
+ * every failure helper fires a probe named after it with the API name as its
+ * first argument, e.g.
+ *
+ *   bpftrace -e 'usdt:./app:safec:checked_memcpy { @[arg0] = hist(arg0); }'
+ *
+ * Each probe is guarded by its semaphore, so a probe that no tracer is
+ * attached to costs a load and a not-taken branch and never evaluates its
+ * arguments. Define SAFEC_NO_USDT to compile the probes out entirely.
+ *
+ * The probes write their own SystemTap notes rather than using <sys/sdt.h>:
+ * semaphores there are switched on for a whole translation unit by
+ * _SDT_HAS_SEMAPHORES, which would also require a semaphore for every probe
+ * of the including program. The notes follow the same format (version 3),
+ * name the safec_<probe>_semaphore variables for this provider only, and
+ * pass every argument as a uintptr_t in a register.
+ */
+#ifdef SAFEC_USDT
+#define SAFEC_USDT_SEMAPHORE(name)                                 \
+  __attribute__((weak, unused, section(".probes"))) unsigned short \
+      safec_##name##_semaphore;
+#define SAFEC_USDT_ENABLED(name) \
+  __builtin_expect(safec_##name##_semaphore != 0, 0)
+#ifdef __LP64__
+#define SAFEC_USDT_ADDR ".8byte"
+#define SAFEC_USDT_ARG(n) "8@%" #n
+#else
+#define SAFEC_USDT_ADDR ".4byte"
+#define SAFEC_USDT_ARG(n) "4@%" #n
+#endif
+// A nop for the tracer to patch, and a .note.stapsdt entry describing it.
+#define SAFEC_USDT_NOTE(name, arguments, ...)                                 \
+  __asm__ __volatile__(                                                       \
+      "990: nop\n"                                                            \
+      ".pushsection .note.stapsdt,\"?\",\"note\"\n"                           \
+      ".balign 4\n"                                                           \
+      ".4byte 992f-991f, 994f-993f, 3\n"                                      \
+      "991: .asciz \"stapsdt\"\n"                                             \
+      "992: .balign 4\n"                                                      \
+      "993: " SAFEC_USDT_ADDR " 990b\n"                                       \
+      SAFEC_USDT_ADDR " _.stapsdt.base\n"                                     \
+      SAFEC_USDT_ADDR " safec_" #name "_semaphore\n"                          \
+      ".asciz \"safec\"\n"                                                    \
+      ".asciz \"" #name "\"\n"                                                \
+      ".asciz \"" arguments "\"\n"                                            \
+      "994: .balign 4\n"                                                      \
+      ".popsection\n"                                                         \
+      ".ifndef _.stapsdt.base\n"                                              \
+      ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+      ".weak _.stapsdt.base\n"                                                \
+      ".hidden _.stapsdt.base\n"                                              \
+      "_.stapsdt.base: .space 1\n"                                            \
+      ".size _.stapsdt.base, 1\n"                                             \
+      ".popsection\n"                                                         \
+      ".endif\n"                                                              \
+      :                                                                       \
+      : __VA_ARGS__)
+#define SAFEC_USDT_PROBE1(name, arg1)                                   \
+  do {                                                                  \
+    if (SAFEC_USDT_ENABLED(name)) {                                     \
+      SAFEC_USDT_NOTE(name, SAFEC_USDT_ARG(0), "r"((uintptr_t)(arg1))); \
+    }                                                                   \
+  } while (0)
+#define SAFEC_USDT_PROBE2(name, arg1, arg2)        \
+  do {                                             \
+    if (SAFEC_USDT_ENABLED(name)) {                \
+      SAFEC_USDT_NOTE(                             \
+          name,                                    \
+          SAFEC_USDT_ARG(0) " " SAFEC_USDT_ARG(1), \
+          "r"((uintptr_t)(arg1)),                  \
+          "r"((uintptr_t)(arg2)));                 \
+    }                                              \
+  } while (0)
+#define SAFEC_USDT_PROBE3(name, arg1, arg2, arg3)                        \
+  do {                                                                   \
+    if (SAFEC_USDT_ENABLED(name)) {                                      \
+      SAFEC_USDT_NOTE(                                                   \
+          name,                                                          \
+          SAFEC_USDT_ARG(0) " " SAFEC_USDT_ARG(1) " " SAFEC_USDT_ARG(2), \
+          "r"((uintptr_t)(arg1)),                                        \
+          "r"((uintptr_t)(arg2)),                                        \
+          "r"((uintptr_t)(arg3)));                                       \
+    }                                                                    \
+  } while (0)
+#else
+#define SAFEC_USDT_SEMAPHORE(name)
+#define SAFEC_USDT_PROBE1(name, arg1) ((void)0)
+#define SAFEC_USDT_PROBE2(name, arg1, arg2) ((void)0)
+#define SAFEC_USDT_PROBE3(name, arg1, arg2, arg3) ((void)0)
+#endif
+
+SAFEC_USDT_SEMAPHORE(buffer_overflow_error_with_size)
+SAFEC_USDT_SEMAPHORE(buffer_overflow_error)
+SAFEC_USDT_SEMAPHORE(buffer_oob_read_error)
+SAFEC_USDT_SEMAPHORE(integer_overflow_error)
+SAFEC_USDT_SEMAPHORE(null_pointer_error)
+SAFEC_USDT_SEMAPHORE(invalid_argument_error)
+SAFEC_USDT_SEMAPHORE(out_of_memory_error)
+SAFEC_USDT_SEMAPHORE(io_error)
+
 static inline void error_print(const char* msg) {
   const size_t msg_length = strlen(msg);
 #if !defined(_WIN32) && !defined(_WIN64)
@@ -66,6 +230,11 @@ static inline NO_RETURN void buffer_overflow_error_with_size(
     const char* api_name,
     size_t destination_size,
     size_t writing_size) {
+  SAFEC_USDT_PROBE3(
+      buffer_overflow_error_with_size,
+      api_name,
+      destination_size,
+      writing_size);
   char error_msg[128]; // fixture + digits: 87 + 20 + 20 ~= 128
   snprintf(
       error_msg,
@@ -77,389 +246,6400 @@ static inline NO_RETURN void buffer_overflow_error_with_size(
 }
 
 static inline NO_RETURN void buffer_overflow_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(buffer_overflow_error, api_name);
   error_with_prefix_msg(
       api_name, "[err] Aborting due to potential buffer overflow in: ");
 }
 
 static inline NO_RETURN void buffer_oob_read_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(buffer_oob_read_error, api_name);
   error_with_prefix_msg(
       api_name,
       "[err] Aborting due to potential buffer out-of-bounds read in: ");
 }
 
 static inline NO_RETURN void integer_overflow_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(integer_overflow_error, api_name);
   error_with_prefix_msg(
       api_name, "[err] Aborting due to potential integer overflow in: ");
 }
 
 static inline NO_RETURN void null_pointer_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(null_pointer_error, api_name);
   error_with_prefix_msg(
       api_name, "[err] Aborting due to unexpected null pointer in: ");
 }
 
-/**
- * Bounds checking (i.e. destination) wrapper for std::memcpy. This version
- * aborts the process if there's a possibility of buffer overflow.
- *
- * @param destination
- *      Pointer to the destination where the content is to be copied.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be copied.
- * @param count
- *      Number of bytes to copy.
- * @return void *
- *      Pointer to the destination.
- */
-
-static inline void* checked_memcpy(
-    void* destination,
-    size_t destination_size,
-    const void* source,
-    size_t count) {
-  if (destination_size < count) {
-    buffer_overflow_error_with_size(__func__, destination_size, count);
-  }
-  if (source == BAD_PTR || destination == BAD_PTR) {
-    null_pointer_error(__func__);
-  }
-  return memcpy(destination, source, count);
+static inline NO_RETURN void invalid_argument_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(invalid_argument_error, api_name);
+  error_with_prefix_msg(
+      api_name, "[err] Aborting due to invalid argument in: ");
 }
 
-/**
- * Bounds checking (i.e. destination) wrapper for std::memcpy. This version
- * aborts the process if there would be a buffer overflow, and allows for
- * safely writing to an offset within the buffer
- *
- * @param destination
- *      Pointer to the destination where the content is to be copied.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer). This value should be greater than or equal to offset
- * + count.
- * @param offset
- *      The number of bytes to offset the copied bytes into the destination
- * buffer.
- * @param source
- *      Pointer to the source of data to be copied.
- * @param count
- *      Number of bytes to copy.
- * @return void *
- *      Pointer to the destination.
- *      Note - not the offset that was written to.
- *      TODO - may need to reconsider returning the offset as we put this into
- * code
- */
-
-static inline void* checked_memcpy_offset(
-    void* destination,
-    size_t destination_size,
-    size_t offset,
-    const void* source,
-    size_t count) {
-  // Naively, we could just check count > destination_size - offset. However,
-  // if offset is very large, e.g. size_t(-1), then destination_size - offset
-  // will overflow `size_t` and hence act additive to destination_size.
-  //
-  // To avoid this, we properly compute the available_size and then check that.
-
-  const size_t available_size =
-      offset > destination_size ? 0 : destination_size - offset;
-
-  if (count > available_size) {
-    buffer_overflow_error_with_size(__func__, available_size, count);
-  }
+static inline NO_RETURN void out_of_memory_error(
+    const char* api_name,
+    size_t allocation_size) {
+  SAFEC_USDT_PROBE2(out_of_memory_error, api_name, allocation_size);
+  char error_msg[80]; // fixture + digits: 50 + 20 ~= 80
+  snprintf(
+      error_msg,
+      80,
+      "[err] Aborting due to failed allocation of size %zu in: ",
+      allocation_size);
+  error_with_prefix_msg(api_name, error_msg);
+}
 
-  memcpy((char*)destination + offset, source, count);
-  return destination;
+static inline NO_RETURN void io_error(const char* api_name) {
+  SAFEC_USDT_PROBE1(io_error, api_name);
+  error_with_prefix_msg(api_name, "[err] Aborting due to failed I/O in: ");
 }
 
-/**
- * Bounds checking (i.e. both source and destination) wrapper for std::memcpy.
- * This version aborts the process if there's a possibility of buffer overflow.
+/*
+ * Overflow-checked size arithmetic.
  *
- * @param destination
- *      Pointer to the destination where the content is to be copied.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be copied.
- * @param source_size
- *      Max number of bytes to copy from the source (typically the size of the
- * source buffer).
- * @param count
- *      Number of bytes to copy.
- * @return void *
- *      Pointer to the destination.
+ * checked_mul_size() and checked_add_size() compute the count * elem_size
+ * style sizes that feed destination_size, so the overflow check lives in one
+ * place instead of an ad-hoc division at every call site.
  */
-static inline void* checked_memcpy_robust(
-    void* destination,
-    size_t destination_size,
-    const void* source,
-    size_t source_size,
-    size_t count) {
-  if (destination_size < count || source_size < count) {
-    buffer_overflow_error(__func__);
-  }
-  return memcpy(destination, source, count);
-}
 
 /**
- * Bounds checking (i.e. destination) wrapper for std::memcpy. This version adds
- * bounds checking capability and returns an error code if there's any potential
- * buffer overflow detected. Error handling is mandatory. Note that using this
- * function without error handling does not guarantee security.
+ * Computes a * b.
  *
- * @param destination
- *      Pointer to the destination where the content is to be copied.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be copied.
- * @param count
- *      Number of bytes to copy.
+ * @param result
+ *      Receives the product on success and is left untouched otherwise.
  * @return int
- *      Returns zero on success and non-zero value on error.
+ *      Returns zero on success and ERR_POTENTIAL_INTEGER_OVERFLOW if the
+ * product does not fit in size_t.
  */
-SECURE_LIB_WARN_UNUSED_RESULT static inline int try_checked_memcpy(
-    void* destination,
-    size_t destination_size,
-    const void* source,
-    size_t count) {
-  if (destination_size < count) {
-    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_checked_mul_size(size_t a, size_t b, size_t* result) {
+  size_t product;
+#if defined(__GNUC__) || defined(__clang__)
+  if (__builtin_mul_overflow(a, b, &product)) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+#else
+  if (b != 0 && a > SIZE_MAX / b) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
   }
-  memcpy(destination, source, count);
+  product = a * b;
+#endif
+  *result = product;
   return 0;
 }
 
 /**
- * Bounds checking (i.e. both source and destination) wrapper for std::memcpy.
- * This version adds bounds checking capability and returns an error code if
- * there's any potential buffer overflow detected. Error handling is mandatory.
- * Note that using this function without error handling does not guarantee
- * security.
+ * Computes a + b.
  *
- * @param destination
- *      Pointer to the destination where the content is to be copied.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be copied.
- * @param source_size
- *      Max number of bytes to copy from the source (typically the size of the
- * source buffer).
- * @param count
- *      Number of bytes to copy.
+ * @param result
+ *      Receives the sum on success and is left untouched otherwise.
  * @return int
- *      Returns zero on success and non-zero value on error.
+ *      Returns zero on success and ERR_POTENTIAL_INTEGER_OVERFLOW if the sum
+ * does not fit in size_t.
  */
-SECURE_LIB_WARN_UNUSED_RESULT static inline int try_checked_memcpy_robust(
-    void* destination,
-    size_t destination_size,
-    const void* source,
-    size_t source_size,
-    size_t count) {
-  if (destination_size < count || source_size < count) {
-    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_checked_add_size(size_t a, size_t b, size_t* result) {
+  size_t sum;
+#if defined(__GNUC__) || defined(__clang__)
+  if (__builtin_add_overflow(a, b, &sum)) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
   }
-  memcpy(destination, source, count);
+#else
+  sum = a + b;
+  if (sum < a) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+#endif
+  *result = sum;
   return 0;
 }
 
 /**
- * Bounds checking (i.e. destination) wrapper for std::strcat. This version
- * aborts the process if there's a possibility of buffer overflow.
- *
- * @param destination
- *      Pointer to the destination where the content is to be concatenated.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be concatenated into destination.
- * @return char *
- *      Pointer to the destination.
+ * Computes a * b. This version aborts the process if the product does not
+ * fit in size_t.
  */
-
-static inline char*
-checked_strcat(char* destination, size_t destination_size, const char* source) {
-  const size_t dest_str_len = strlen(destination);
-  const size_t src_str_len = strlen(source);
-  const size_t tot_str_len = dest_str_len + src_str_len;
-
-  if (destination_size == 0) {
-    buffer_overflow_error_with_size(__func__, destination_size, tot_str_len);
-  }
-
-  if (dest_str_len + src_str_len < dest_str_len) {
+static inline size_t checked_mul_size(size_t a, size_t b) {
+  size_t product;
+  if (try_checked_mul_size(a, b, &product) != 0) {
     integer_overflow_error(__func__);
   }
+  return product;
+}
 
-  if (destination_size - 1 < tot_str_len) {
-    buffer_overflow_error_with_size(
-        __func__, destination_size - 1, tot_str_len);
+/**
+ * Computes a + b. This version aborts the process if the sum does not fit in
+ * size_t.
+ */
+static inline size_t checked_add_size(size_t a, size_t b) {
+  size_t sum;
+  if (try_checked_add_size(a, b, &sum) != 0) {
+    integer_overflow_error(__func__);
   }
-  // We already know lengths, use memcpy
-  memcpy(destination + dest_str_len, source, src_str_len);
-  *(destination + dest_str_len + src_str_len) = '\0';
-  return destination;
+  return sum;
 }
 
-/**
- * Bounds checking (i.e. destination) wrapper for std::strcat. This version adds
- * bounds checking capability and returns an error code if there's any potential
- * buffer overflow detected. Error handling is mandatory. Note that using this
- * function without error handling does not guarantee security.
+/*
+ * Opt-in per-call-site instrumentation.
  *
- * @param destination
- *      Pointer to the destination where the content is to be concatenated.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param source
- *      Pointer to the source of data to be concatenated into destination.
- * @return int
- *      Returns zero on success and non-zero value on error.
+ * Defining SAFEC_STATS before including this header makes every checked
+ * wrapper record, per call site, how often it ran and a log2 histogram of the
+ * sizes it handled. Call sites are keyed by __builtin_return_address(0), so
+ * the wrappers are compiled out-of-line in this mode; resolve the reported
+ * addresses (relative to the module base for PIE) with addr2line. Counters
+ * live in per-thread shards that are only written by their owning thread (no
+ * atomic read-modify-write on the hot path) and are merged on demand by
+ * safec_stats_dump().
+ *
+ * Defining SAFEC_HEADROOM records, in the same per-site tables, the largest
+ * count and limit each site has seen and the smallest slack (limit - count)
+ * it ever left. safec_headroom_report() then lists the most over-provisioned
+ * destinations and the sites closest to overflowing.
+ *
+ * Defining SAFEC_PROFILE timestamps every checked operation (rdtscp on x86,
+ * the virtual counter on AArch64, clock_gettime() elsewhere) and accumulates
+ * per site the ticks spent in the bounds checks and in the underlying
+ * libc call. safec_profile_write_report() writes a report ranked by total
+ * ticks; it also runs at exit, writing to $SAFEC_PROFILE_OUTPUT or
+ * safec_profile.<pid>.txt.
+ *
+ * These macros must be defined consistently in every translation unit of a
+ * program.
+ *
+ * For every operation the recorded "count" is the number of destination bytes
+ * the call needs and "limit" is the number of bytes it is allowed to touch.
  */
-SECURE_LIB_WARN_UNUSED_RESULT static inline int try_checked_strcat(
-    char* destination,
-    size_t destination_size,
-    const char* source) {
-  if (destination_size == 0) {
-    return ERR_POTENTIAL_BUFFER_OVERFLOW;
-  }
+#if defined(SAFEC_STATS) || defined(SAFEC_HEADROOM) || defined(SAFEC_PROFILE)
+#define SAFEC_SITE_TABLE 1
+#endif
 
-  const size_t dest_str_len = strlen(destination);
-  const size_t src_str_len = strlen(source);
-  if (dest_str_len + src_str_len < dest_str_len) {
-    return ERR_POTENTIAL_INTEGER_OVERFLOW;
-  }
+#define SAFEC_FOR_EACH_API(X)   \
+  X(checked_memcpy)             \
+  X(checked_memcpy_offset)      \
+  X(checked_memcpy_robust)      \
+  X(try_checked_memcpy)         \
+  X(try_checked_memcpy_robust)  \
+  X(checked_strcat)             \
+  X(try_checked_strcat)         \
+  X(checked_memcmp)             \
+  X(checked_strncmp)            \
+  X(checked_memset)             \
+  X(try_checked_memcpy_offset)  \
+  X(try_checked_memcmp)         \
+  X(try_checked_strncmp)        \
+  X(try_checked_memset)         \
+  X(checked_memcpy_clamp)       \
+  X(checked_strcat_clamp)       \
+  X(checked_memcpy_elems)       \
+  X(try_checked_memcpy_elems)   \
+  X(checked_memcpy_auto)        \
+  X(try_checked_memcpy_auto)    \
+  X(checked_memcpy_bswap16)     \
+  X(checked_memcpy_bswap32)     \
+  X(checked_memcpy_bswap64)     \
+  X(try_checked_memcpy_bswap16) \
+  X(try_checked_memcpy_bswap32) \
+  X(try_checked_memcpy_bswap64) \
+  X(checked_memcpy_crc32c)      \
+  X(try_checked_memcpy_crc32c)  \
+  X(checked_memcpy_2d)          \
+  X(try_checked_memcpy_2d)      \
+  X(checked_memset16)           \
+  X(checked_memset32)           \
+  X(checked_memset64)           \
+  X(try_checked_memset16)       \
+  X(try_checked_memset32)       \
+  X(try_checked_memset64)       \
+  X(checked_memset_pattern)     \
+  X(try_checked_memset_pattern) \
+  X(checked_memzero_large)      \
+  X(try_checked_memzero_large)  \
+  X(checked_memmove_pages)      \
+  X(try_checked_memmove_pages)  \
+  X(checked_copy_fd_range)      \
+  X(try_checked_copy_fd_range)
 
-  if (destination_size - 1 < dest_str_len + src_str_len) {
-    return ERR_POTENTIAL_BUFFER_OVERFLOW;
-  }
+enum safec_api {
+#define SAFEC_API_ENUM(name) safec_api_##name,
+  SAFEC_FOR_EACH_API(SAFEC_API_ENUM)
+#undef SAFEC_API_ENUM
+      safec_api_count
+};
 
-  memcpy(destination + dest_str_len, source, src_str_len);
-  *(destination + dest_str_len + src_str_len) = '\0';
-  return 0;
+SAFEC_FOR_EACH_API(SAFEC_USDT_SEMAPHORE)
+
+static inline const char* safec_api_name(unsigned api) {
+  static const char* const names[] = {
+#define SAFEC_API_NAME(name) #name,
+      SAFEC_FOR_EACH_API(SAFEC_API_NAME)
+#undef SAFEC_API_NAME
+  };
+  return api < safec_api_count ? names[api] : "unknown";
 }
 
-/**
- * Bounds checking (i.e. src, dest) wrapper for std::memcmp. This version
- * aborts the process if there's a possibility of reading out-of-bounds.
+#if defined(SAFEC_PROFILE) || defined(SAFEC_TRACE) || \
+    defined(SAFEC_TRACE_REPLAY)
+static inline uint64_t safec_now_ns(void) {
+#ifdef CLOCK_MONOTONIC
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#else
+  // Strict ISO C modes (-std=c99 without _POSIX_C_SOURCE) declare neither the
+  // POSIX clocks nor struct timespec, so fall back to the coarser processor
+  // time.
+  return (uint64_t)((double)clock() * (1e9 / CLOCKS_PER_SEC));
+#endif
+}
+#endif
+
+#ifdef SAFEC_SITE_TABLE
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC instrumentation requires a GCC-compatible compiler on POSIX"
+#endif
+
+#ifndef SAFEC_SITE_TABLE_CAPACITY
+#define SAFEC_SITE_TABLE_CAPACITY 256 // per thread, must be a power of two
+#endif
+
+// Bucket 0 counts zero-sized operations, bucket k counts sizes in
+// [2^(k-1), 2^k), and the last bucket also absorbs everything larger.
+#define SAFEC_STATS_HISTOGRAM_BUCKETS 33
+
+// Wrappers are kept out-of-line so that the return address identifies the
+// caller.
+#define SAFEC_API static __attribute__((noinline, unused))
+#define SAFEC_CALL_SITE() __builtin_return_address(0)
+
+// Process-wide state shared by every translation unit that includes this
+// header.
+#define SAFEC_SHARED __attribute__((weak))
+
+struct safec_site_stats {
+  const void* site;
+  unsigned api;
+  uint64_t calls;
+  uint64_t bytes;
+  uint64_t size_histogram[SAFEC_STATS_HISTOGRAM_BUCKETS];
+  uint64_t max_count;
+  uint64_t max_limit;
+  uint64_t min_slack; // UINT64_MAX until the first call
+  uint64_t overflows; // calls whose count exceeded their limit
+  uint64_t timed_calls; // calls that passed their checks
+  uint64_t check_ticks;
+  uint64_t copy_ticks;
+};
+
+struct safec_site_shard {
+  struct safec_site_shard* next;
+  int in_use;
+  uint64_t dropped; // calls not recorded because the table was full
+  struct safec_site_stats sites[SAFEC_SITE_TABLE_CAPACITY];
+};
+
+SAFEC_SHARED pthread_mutex_t safec_site_registry_lock =
+    PTHREAD_MUTEX_INITIALIZER;
+SAFEC_SHARED pthread_once_t safec_site_registry_once = PTHREAD_ONCE_INIT;
+SAFEC_SHARED pthread_key_t safec_site_registry_key;
+SAFEC_SHARED struct safec_site_shard* safec_site_registry_head;
+SAFEC_SHARED __thread struct safec_site_shard* safec_site_tls_shard;
+SAFEC_SHARED __thread int safec_site_tls_released; // set once the thread exits
+
+// Counters are only ever written by the owning thread; relaxed loads and
+// stores compile to plain moves while keeping concurrent dumps well defined.
+static inline void safec_counter_add(uint64_t* counter, uint64_t value) {
+  __atomic_store_n(
+      counter,
+      __atomic_load_n(counter, __ATOMIC_RELAXED) + value,
+      __ATOMIC_RELAXED);
+}
+
+static inline uint64_t safec_counter_load(const uint64_t* counter) {
+  return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static inline void safec_counter_max(uint64_t* counter, uint64_t value) {
+  if (value > __atomic_load_n(counter, __ATOMIC_RELAXED)) {
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+  }
+}
+
+static inline void safec_counter_min(uint64_t* counter, uint64_t value) {
+  if (value < __atomic_load_n(counter, __ATOMIC_RELAXED)) {
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+  }
+}
+
+static inline void safec_site_shard_release(void* shard) {
+  // Other TLS destructors may run after this one and still call checked
+  // functions. Detach the shard first so that their samples are dropped
+  // instead of landing in a shard that another thread may own by then.
+  safec_site_tls_shard = NULL;
+  safec_site_tls_released = 1;
+  (void)pthread_setspecific(safec_site_registry_key, NULL);
+  // Shards are never freed: the counts of exited threads stay visible to
+  // later dumps and the shard is handed to the next thread that needs one.
+  pthread_mutex_lock(&safec_site_registry_lock);
+  ((struct safec_site_shard*)shard)->in_use = 0;
+  pthread_mutex_unlock(&safec_site_registry_lock);
+}
+
+#ifdef SAFEC_PROFILE
+static inline void safec_profile_atexit(void);
+#endif
+
+static inline void safec_site_registry_init(void) {
+  (void)pthread_key_create(&safec_site_registry_key, safec_site_shard_release);
+#ifdef SAFEC_PROFILE
+  (void)atexit(safec_profile_atexit);
+#endif
+}
+
+static inline struct safec_site_shard* safec_site_shard_acquire(void) {
+  pthread_once(&safec_site_registry_once, safec_site_registry_init);
+
+  pthread_mutex_lock(&safec_site_registry_lock);
+  struct safec_site_shard* shard = safec_site_registry_head;
+  while (shard != NULL && shard->in_use) {
+    shard = shard->next;
+  }
+  if (shard == NULL) {
+    shard = (struct safec_site_shard*)calloc(1, sizeof(*shard));
+    if (shard != NULL) {
+      shard->next = safec_site_registry_head;
+      __atomic_store_n(&safec_site_registry_head, shard, __ATOMIC_RELEASE);
+    }
+  }
+  if (shard != NULL) {
+    shard->in_use = 1;
+  }
+  pthread_mutex_unlock(&safec_site_registry_lock);
+
+  if (shard != NULL) {
+    (void)pthread_setspecific(safec_site_registry_key, shard);
+    safec_site_tls_shard = shard;
+  }
+  return shard;
+}
+
+static inline struct safec_site_stats* safec_site_lookup(
+    unsigned api,
+    const void* site) {
+  struct safec_site_shard* shard = safec_site_tls_shard;
+  if (__builtin_expect(shard == NULL, 0)) {
+    if (safec_site_tls_released) {
+      return NULL;
+    }
+    shard = safec_site_shard_acquire();
+    if (shard == NULL) {
+      return NULL;
+    }
+  }
+
+  const size_t mask = SAFEC_SITE_TABLE_CAPACITY - 1;
+  size_t index = (size_t)(((uint64_t)(uintptr_t)site ^ api) *
+                              UINT64_C(0x9E3779B97F4A7C15) >>
+                          32) &
+      mask;
+  for (size_t probe = 0; probe <= mask; ++probe) {
+    struct safec_site_stats* entry = &shard->sites[index];
+    if (entry->site == site && entry->api == api) {
+      return entry;
+    }
+    if (entry->site == NULL) {
+      entry->api = api;
+      entry->min_slack = UINT64_MAX;
+      __atomic_store_n(&entry->site, site, __ATOMIC_RELEASE);
+      return entry;
+    }
+    index = (index + 1) & mask;
+  }
+  safec_counter_add(&shard->dropped, 1);
+  return NULL;
+}
+
+static inline unsigned safec_size_bucket(size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+  const unsigned bucket = 64 - (unsigned)__builtin_clzll((uint64_t)size);
+  return bucket < SAFEC_STATS_HISTOGRAM_BUCKETS
+      ? bucket
+      : SAFEC_STATS_HISTOGRAM_BUCKETS - 1;
+}
+
+static inline struct safec_site_stats* safec_site_record(
+    unsigned api,
+    const void* site,
+    size_t count,
+    size_t limit) {
+  struct safec_site_stats* entry = safec_site_lookup(api, site);
+  if (entry == NULL) {
+    return NULL;
+  }
+  (void)count;
+  (void)limit;
+  safec_counter_add(&entry->calls, 1);
+#ifdef SAFEC_STATS
+  safec_counter_add(&entry->bytes, count);
+  safec_counter_add(&entry->size_histogram[safec_size_bucket(count)], 1);
+#endif
+#ifdef SAFEC_HEADROOM
+  safec_counter_max(&entry->max_count, count);
+  safec_counter_max(&entry->max_limit, limit);
+  if (count > limit) {
+    safec_counter_add(&entry->overflows, 1);
+    safec_counter_min(&entry->min_slack, 0);
+  } else {
+    safec_counter_min(&entry->min_slack, limit - count);
+  }
+#endif
+  return entry;
+}
+
+static inline void safec_site_stats_accumulate(
+    struct safec_site_stats* into,
+    const struct safec_site_stats* from) {
+  into->calls += safec_counter_load(&from->calls);
+  into->bytes += safec_counter_load(&from->bytes);
+  for (unsigned i = 0; i < SAFEC_STATS_HISTOGRAM_BUCKETS; ++i) {
+    into->size_histogram[i] += safec_counter_load(&from->size_histogram[i]);
+  }
+  const uint64_t max_count = safec_counter_load(&from->max_count);
+  const uint64_t max_limit = safec_counter_load(&from->max_limit);
+  const uint64_t min_slack = safec_counter_load(&from->min_slack);
+  into->max_count = max_count > into->max_count ? max_count : into->max_count;
+  into->max_limit = max_limit > into->max_limit ? max_limit : into->max_limit;
+  into->min_slack = min_slack < into->min_slack ? min_slack : into->min_slack;
+  into->overflows += safec_counter_load(&from->overflows);
+  into->timed_calls += safec_counter_load(&from->timed_calls);
+  into->check_ticks += safec_counter_load(&from->check_ticks);
+  into->copy_ticks += safec_counter_load(&from->copy_ticks);
+}
+
+static inline int safec_site_stats_compare_key(
+    const void* lhs,
+    const void* rhs) {
+  const struct safec_site_stats* a = (const struct safec_site_stats*)lhs;
+  const struct safec_site_stats* b = (const struct safec_site_stats*)rhs;
+  if (a->site != b->site) {
+    return (uintptr_t)a->site < (uintptr_t)b->site ? -1 : 1;
+  }
+  return a->api < b->api ? -1 : a->api > b->api;
+}
+
+/**
+ * Merges the per-thread shards into one entry per (call site, API) pair.
+ * Concurrent callers may still be updating their shards, so the result is a
+ * consistent-per-counter snapshot rather than an atomic one.
+ *
+ * @param count
+ *      Receives the number of merged entries.
+ * @param dropped
+ *      Receives the number of calls that were not recorded because a
+ * per-thread table was full (may be NULL).
+ * @return struct safec_site_stats *
+ *      Array of merged entries to be released with free(), or NULL if there
+ * is nothing to report or memory could not be allocated.
+ */
+static inline struct safec_site_stats* safec_site_stats_merge(
+    size_t* count,
+    uint64_t* dropped) {
+  *count = 0;
+  if (dropped != NULL) {
+    *dropped = 0;
+  }
+
+  pthread_mutex_lock(&safec_site_registry_lock);
+  size_t shards = 0;
+  for (struct safec_site_shard* shard = safec_site_registry_head;
+       shard != NULL;
+       shard = shard->next) {
+    ++shards;
+  }
+  struct safec_site_stats* merged = NULL;
+  if (shards != 0) {
+    merged = (struct safec_site_stats*)malloc(
+        shards * SAFEC_SITE_TABLE_CAPACITY * sizeof(*merged));
+  }
+  size_t used = 0;
+  for (struct safec_site_shard* shard = safec_site_registry_head;
+       merged != NULL && shard != NULL;
+       shard = shard->next) {
+    if (dropped != NULL) {
+      *dropped += safec_counter_load(&shard->dropped);
+    }
+    for (size_t i = 0; i < SAFEC_SITE_TABLE_CAPACITY; ++i) {
+      const struct safec_site_stats* entry = &shard->sites[i];
+      const void* site = __atomic_load_n(&entry->site, __ATOMIC_ACQUIRE);
+      if (site == NULL) {
+        continue;
+      }
+      struct safec_site_stats* out = &merged[used++];
+      memset(out, 0, sizeof(*out));
+      out->site = site;
+      out->api = entry->api;
+      out->min_slack = UINT64_MAX;
+      safec_site_stats_accumulate(out, entry);
+    }
+  }
+  pthread_mutex_unlock(&safec_site_registry_lock);
+
+  if (merged == NULL || used == 0) {
+    free(merged);
+    return NULL;
+  }
+
+  qsort(merged, used, sizeof(*merged), safec_site_stats_compare_key);
+  size_t unique = 0;
+  for (size_t i = 0; i < used; ++i) {
+    if (unique != 0 &&
+        safec_site_stats_compare_key(&merged[unique - 1], &merged[i]) == 0) {
+      safec_site_stats_accumulate(&merged[unique - 1], &merged[i]);
+    } else {
+      if (unique != i) {
+        merged[unique] = merged[i];
+      }
+      ++unique;
+    }
+  }
+  *count = unique;
+  return merged;
+}
+
+static inline int safec_site_stats_compare_calls(
+    const void* lhs,
+    const void* rhs) {
+  const struct safec_site_stats* a = (const struct safec_site_stats*)lhs;
+  const struct safec_site_stats* b = (const struct safec_site_stats*)rhs;
+  if (a->calls != b->calls) {
+    return a->calls > b->calls ? -1 : 1;
+  }
+  return safec_site_stats_compare_key(lhs, rhs);
+}
+
+#ifdef SAFEC_STATS
+/**
+ * Writes the merged per-call-site statistics to out, hottest sites first.
+ * Each line names the call site (a return address, see addr2line), the
+ * wrapper, the number of calls, the total bytes and the non-empty log2 size
+ * buckets as "<upper bound>:<calls>".
+ *
+ * @param out
+ *      Stream to write the report to.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+static inline int safec_stats_dump(FILE* out) {
+  size_t count = 0;
+  uint64_t dropped = 0;
+  struct safec_site_stats* sites = safec_site_stats_merge(&count, &dropped);
+  if (sites != NULL) {
+    qsort(sites, count, sizeof(*sites), safec_site_stats_compare_calls);
+  }
+
+  int ret = fprintf(
+      out,
+      "safec stats: %zu call sites, %llu calls dropped\n",
+      count,
+      (unsigned long long)dropped);
+  for (size_t i = 0; ret >= 0 && i < count; ++i) {
+    const struct safec_site_stats* entry = &sites[i];
+    ret = fprintf(
+        out,
+        "%p %s calls=%llu bytes=%llu sizes:",
+        entry->site,
+        safec_api_name(entry->api),
+        (unsigned long long)entry->calls,
+        (unsigned long long)entry->bytes);
+    for (unsigned b = 0; ret >= 0 && b < SAFEC_STATS_HISTOGRAM_BUCKETS; ++b) {
+      if (entry->size_histogram[b] == 0) {
+        continue;
+      }
+      const int last = b == SAFEC_STATS_HISTOGRAM_BUCKETS - 1;
+      ret = fprintf(
+          out,
+          " %s%llu:%llu",
+          last ? ">=" : "<",
+          b == 0 ? 1ULL : (last ? 1ULL << (b - 1) : 1ULL << b),
+          (unsigned long long)entry->size_histogram[b]);
+    }
+    if (ret >= 0) {
+      ret = fputc('\n', out);
+    }
+  }
+  free(sites);
+  return ret < 0 ? -1 : 0;
+}
+#endif // SAFEC_STATS
+
+#ifdef SAFEC_HEADROOM
+static inline int safec_site_stats_compare_slack(
+    const void* lhs,
+    const void* rhs) {
+  const struct safec_site_stats* a = (const struct safec_site_stats*)lhs;
+  const struct safec_site_stats* b = (const struct safec_site_stats*)rhs;
+  if (a->overflows != b->overflows) {
+    return a->overflows > b->overflows ? -1 : 1;
+  }
+  if (a->min_slack != b->min_slack) {
+    return a->min_slack < b->min_slack ? -1 : 1;
+  }
+  return safec_site_stats_compare_calls(lhs, rhs);
+}
+
+static inline int safec_headroom_print(
+    FILE* out,
+    const struct safec_site_stats* entry) {
+  return fprintf(
+      out,
+      "%p %s calls=%llu max_count=%llu max_limit=%llu min_slack=%llu "
+      "overflows=%llu\n",
+      entry->site,
+      safec_api_name(entry->api),
+      (unsigned long long)entry->calls,
+      (unsigned long long)entry->max_count,
+      (unsigned long long)entry->max_limit,
+      (unsigned long long)entry->min_slack,
+      (unsigned long long)entry->overflows);
+}
+
+/**
+ * Writes a buffer headroom report to out. The first section lists the call
+ * sites whose destinations are the most over-provisioned (largest slack that
+ * was never used), the second one the sites closest to overflowing (calls
+ * that exceeded their limit first, then the smallest slack).
+ *
+ * @param out
+ *      Stream to write the report to.
+ * @param max_sites
+ *      Max number of call sites listed in each section.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+static inline int safec_headroom_report(FILE* out, size_t max_sites) {
+  size_t count = 0;
+  uint64_t dropped = 0;
+  struct safec_site_stats* sites = safec_site_stats_merge(&count, &dropped);
+  const size_t listed = count < max_sites ? count : max_sites;
+
+  int ret = fprintf(
+      out,
+      "safec headroom: %zu call sites, %llu calls dropped\n"
+      "most over-provisioned:\n",
+      count,
+      (unsigned long long)dropped);
+  if (sites != NULL) {
+    qsort(sites, count, sizeof(*sites), safec_site_stats_compare_slack);
+  }
+  for (size_t i = 0; ret >= 0 && i < listed; ++i) {
+    const struct safec_site_stats* entry = &sites[count - 1 - i];
+    if (entry->overflows != 0) {
+      break;
+    }
+    ret = safec_headroom_print(out, entry);
+  }
+  if (ret >= 0) {
+    ret = fprintf(out, "closest to overflow:\n");
+  }
+  for (size_t i = 0; ret >= 0 && i < listed; ++i) {
+    ret = safec_headroom_print(out, &sites[i]);
+  }
+  free(sites);
+  return ret < 0 ? -1 : 0;
+}
+#endif // SAFEC_HEADROOM
+
+#ifdef SAFEC_PROFILE
+#if defined(__x86_64__) || defined(__i386__)
+#define SAFEC_PROFILE_TICK_UNIT "cycles"
+#elif defined(__aarch64__)
+#define SAFEC_PROFILE_TICK_UNIT "counter ticks"
+#else
+#define SAFEC_PROFILE_TICK_UNIT "ns"
+#endif
+
+static inline uint64_t safec_profile_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  // rdtscp waits for the preceding instructions to retire.
+  unsigned int aux;
+  return __builtin_ia32_rdtscp(&aux);
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks)::"memory");
+  return ticks;
+#else
+  return safec_now_ns();
+#endif
+}
+
+static inline void safec_profile_record(
+    struct safec_site_stats* entry,
+    uint64_t start,
+    uint64_t copy_start,
+    uint64_t end) {
+  if (entry == NULL) {
+    return;
+  }
+  safec_counter_add(&entry->timed_calls, 1);
+  safec_counter_add(&entry->check_ticks, copy_start - start);
+  safec_counter_add(&entry->copy_ticks, end - copy_start);
+}
+
+static inline int safec_site_stats_compare_ticks(
+    const void* lhs,
+    const void* rhs) {
+  const struct safec_site_stats* a = (const struct safec_site_stats*)lhs;
+  const struct safec_site_stats* b = (const struct safec_site_stats*)rhs;
+  const uint64_t a_ticks = a->check_ticks + a->copy_ticks;
+  const uint64_t b_ticks = b->check_ticks + b->copy_ticks;
+  if (a_ticks != b_ticks) {
+    return a_ticks > b_ticks ? -1 : 1;
+  }
+  return safec_site_stats_compare_calls(lhs, rhs);
+}
+
+/**
+ * Writes the per-call-site cycle accounting report to the file at path,
+ * ranked by the total ticks spent in checked operations. For every site it
+ * lists the ticks spent in the bounds checks and in the underlying libc call,
+ * their averages per call and the share of the checks.
+ *
+ * @param path
+ *      Path of the report file, truncated if it exists.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+static inline int safec_profile_write_report(const char* path) {
+  FILE* out = fopen(path, "w");
+  if (out == NULL) {
+    return -1;
+  }
+  size_t count = 0;
+  uint64_t dropped = 0;
+  struct safec_site_stats* sites = safec_site_stats_merge(&count, &dropped);
+  if (sites != NULL) {
+    qsort(sites, count, sizeof(*sites), safec_site_stats_compare_ticks);
+  }
+
+  int ret = fprintf(
+      out,
+      "safec profile (%s): %zu call sites, %llu calls dropped\n",
+      SAFEC_PROFILE_TICK_UNIT,
+      count,
+      (unsigned long long)dropped);
+  for (size_t i = 0; ret >= 0 && i < count; ++i) {
+    const struct safec_site_stats* entry = &sites[i];
+    const uint64_t timed = entry->timed_calls ? entry->timed_calls : 1;
+    const uint64_t total = entry->check_ticks + entry->copy_ticks;
+    ret = fprintf(
+        out,
+        "%p %s calls=%llu check=%llu copy=%llu check_avg=%llu "
+        "copy_avg=%llu check_share=%.1f%%\n",
+        entry->site,
+        safec_api_name(entry->api),
+        (unsigned long long)entry->calls,
+        (unsigned long long)entry->check_ticks,
+        (unsigned long long)entry->copy_ticks,
+        (unsigned long long)(entry->check_ticks / timed),
+        (unsigned long long)(entry->copy_ticks / timed),
+        total ? 100.0 * (double)entry->check_ticks / (double)total : 0.0);
+  }
+  free(sites);
+  if (fclose(out) != 0) {
+    ret = -1;
+  }
+  return ret < 0 ? -1 : 0;
+}
+
+static inline void safec_profile_atexit(void) {
+  const char* path = getenv("SAFEC_PROFILE_OUTPUT");
+  char default_path[64];
+  if (path == NULL || *path == '\0') {
+    snprintf(
+        default_path,
+        sizeof(default_path),
+        "safec_profile.%ld.txt",
+        (long)getpid());
+    path = default_path;
+  }
+  (void)safec_profile_write_report(path);
+}
+
+// Declares the timing state of the enclosing operation; used as a statement.
+#define SAFEC_PROFILE_OP(name, count, limit)                         \
+  struct safec_site_stats* const safec_op_entry = safec_site_record( \
+      safec_api_##name, SAFEC_CALL_SITE(), (count), (limit));        \
+  const uint64_t safec_op_start = safec_profile_now()
+// Times the underlying libc call of the enclosing operation.
+#define SAFEC_OP_CALL(call)                                   \
+  __extension__({                                             \
+    const uint64_t safec_op_call_start = safec_profile_now(); \
+    __typeof__(call) safec_op_ret = (call);                   \
+    safec_profile_record(                                     \
+        safec_op_entry,                                       \
+        safec_op_start,                                       \
+        safec_op_call_start,                                  \
+        safec_profile_now());                                 \
+    safec_op_ret;                                             \
+  })
+#endif // SAFEC_PROFILE
+
+#define SAFEC_SITE_RECORD(name, count, limit) \
+  safec_site_record(safec_api_##name, SAFEC_CALL_SITE(), (count), (limit))
+
+#else // SAFEC_SITE_TABLE
+
+#define SAFEC_API static inline
+#define SAFEC_SITE_RECORD(name, count, limit) ((void)0)
+
+#endif // SAFEC_SITE_TABLE
+
+/*
+ * Workload trace recording.
+ *
+ * Defining SAFEC_TRACE makes every checked operation append an
+ * (API, destination/source misalignment, count, limit) tuple to a per-thread
+ * buffer that is flushed to a binary trace file when full, on thread exit, on
+ * process exit (for the exiting thread) and on safec_trace_flush(). The file
+ * is $SAFEC_TRACE_OUTPUT or safec_trace.<pid>.bin. It starts with the 8-byte
+ * SAFEC_TRACE_MAGIC followed by records of three bytes (API, destination
+ * address modulo 64, source address modulo 64) and two LEB128 varints (count
+ * and limit). Traces are read back and replayed by safec_trace_load() and
+ * safec_trace_replay(), which are also available with SAFEC_TRACE_REPLAY.
+ */
+#define SAFEC_TRACE_MAGIC "SAFECTR1"
+#define SAFEC_TRACE_ALIGNMENT 64
+
+#ifdef SAFEC_TRACE
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC trace recording requires a GCC-compatible compiler on POSIX"
+#endif
+
+#ifndef SAFEC_TRACE_BUFFER_SIZE
+#define SAFEC_TRACE_BUFFER_SIZE 65536 // per thread
+#endif
+#define SAFEC_TRACE_MAX_RECORD_SIZE (3 + 2 * 10)
+
+struct safec_trace_buffer {
+  size_t used;
+  unsigned char data[SAFEC_TRACE_BUFFER_SIZE];
+};
+
+__attribute__((weak)) pthread_mutex_t safec_trace_lock =
+    PTHREAD_MUTEX_INITIALIZER;
+__attribute__((weak)) pthread_once_t safec_trace_once = PTHREAD_ONCE_INIT;
+__attribute__((weak)) pthread_key_t safec_trace_key;
+__attribute__((weak)) FILE* safec_trace_file;
+__attribute__((weak)) int safec_trace_failed;
+__attribute__((weak)) __thread struct safec_trace_buffer*
+    safec_trace_tls_buffer;
+// Set once the thread exits, and while replaying so that replayed operations
+// are not recorded again.
+__attribute__((weak)) __thread int safec_trace_tls_suppressed;
+
+static inline void safec_trace_write(struct safec_trace_buffer* buffer) {
+  pthread_mutex_lock(&safec_trace_lock);
+  if (safec_trace_file == NULL && !safec_trace_failed) {
+    const char* path = getenv("SAFEC_TRACE_OUTPUT");
+    char default_path[64];
+    if (path == NULL || *path == '\0') {
+      snprintf(
+          default_path,
+          sizeof(default_path),
+          "safec_trace.%ld.bin",
+          (long)getpid());
+      path = default_path;
+    }
+    safec_trace_file = fopen(path, "wb");
+    if (safec_trace_file == NULL ||
+        fwrite(SAFEC_TRACE_MAGIC, 8, 1, safec_trace_file) != 1) {
+      safec_trace_failed = 1;
+    }
+  }
+  if (!safec_trace_failed && buffer->used != 0 &&
+      fwrite(buffer->data, buffer->used, 1, safec_trace_file) != 1) {
+    safec_trace_failed = 1;
+  }
+  if (safec_trace_file != NULL) {
+    fflush(safec_trace_file);
+  }
+  pthread_mutex_unlock(&safec_trace_lock);
+  buffer->used = 0;
+}
+
+static inline void safec_trace_thread_exit(void* buffer) {
+  // Other TLS destructors may run after this one and still call checked
+  // functions. Detach the buffer first so that they neither record into it
+  // after it is freed nor allocate a new one that nothing would release.
+  safec_trace_tls_buffer = NULL;
+  safec_trace_tls_suppressed = 1;
+  (void)pthread_setspecific(safec_trace_key, NULL);
+  safec_trace_write((struct safec_trace_buffer*)buffer);
+  free(buffer);
+}
+
+/**
+ * Writes the calling thread's buffered trace records to the trace file.
+ */
+static inline void safec_trace_flush(void) {
+  if (safec_trace_tls_buffer != NULL) {
+    safec_trace_write(safec_trace_tls_buffer);
+  }
+}
+
+static inline void safec_trace_init(void) {
+  (void)pthread_key_create(&safec_trace_key, safec_trace_thread_exit);
+  (void)atexit(safec_trace_flush);
+}
+
+static inline unsigned char* safec_trace_put_varint(
+    unsigned char* out,
+    uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (unsigned char)value;
+  return out;
+}
+
+static inline void safec_trace_record(
+    unsigned api,
+    const void* destination,
+    const void* source,
+    size_t count,
+    size_t limit) {
+  if (safec_trace_tls_suppressed) {
+    return;
+  }
+  struct safec_trace_buffer* buffer = safec_trace_tls_buffer;
+  if (__builtin_expect(buffer == NULL, 0)) {
+    pthread_once(&safec_trace_once, safec_trace_init);
+    buffer = (struct safec_trace_buffer*)malloc(sizeof(*buffer));
+    if (buffer == NULL) {
+      return;
+    }
+    buffer->used = 0;
+    (void)pthread_setspecific(safec_trace_key, buffer);
+    safec_trace_tls_buffer = buffer;
+  }
+  if (SAFEC_TRACE_BUFFER_SIZE - buffer->used < SAFEC_TRACE_MAX_RECORD_SIZE) {
+    safec_trace_write(buffer);
+  }
+  unsigned char* out = buffer->data + buffer->used;
+  *out++ = (unsigned char)api;
+  *out++ = (unsigned char)((uintptr_t)destination % SAFEC_TRACE_ALIGNMENT);
+  *out++ = (unsigned char)((uintptr_t)source % SAFEC_TRACE_ALIGNMENT);
+  out = safec_trace_put_varint(out, count);
+  out = safec_trace_put_varint(out, limit);
+  buffer->used = (size_t)(out - buffer->data);
+}
+
+#define SAFEC_TRACE_RECORD(name, destination, source, count, limit) \
+  safec_trace_record(                                               \
+      safec_api_##name, (destination), (source), (count), (limit))
+#else
+#define SAFEC_TRACE_RECORD(name, destination, source, count, limit) ((void)0)
+#endif // SAFEC_TRACE
+
+// Hook placed at the top of every checked operation. SAFEC_OP_CALL() wraps
+// the libc call that does the actual work once the checks have passed.
+#ifdef SAFEC_PROFILE
+#define SAFEC_OP(name, destination, source, count, limit)              \
+  SAFEC_USDT_PROBE2(name, (count), (limit));                           \
+  SAFEC_TRACE_RECORD(name, (destination), (source), (count), (limit)); \
+  SAFEC_PROFILE_OP(name, (count), (limit))
+#else
+#define SAFEC_OP(name, destination, source, count, limit)                \
+  do {                                                                   \
+    SAFEC_USDT_PROBE2(name, (count), (limit));                           \
+    SAFEC_TRACE_RECORD(name, (destination), (source), (count), (limit)); \
+    SAFEC_SITE_RECORD(name, (count), (limit));                           \
+  } while (0)
+#define SAFEC_OP_CALL(call) (call)
+#endif
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::memcpy. This version
+ * aborts the process if there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @return void *
+ *      Pointer to the destination.
+ */
+
+SAFEC_API void* checked_memcpy(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t count) {
+  SAFEC_OP(checked_memcpy, destination, source, count, destination_size);
+  if (destination_size < count) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  return SAFEC_OP_CALL(memcpy(destination, source, count));
+}
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::memcpy. This version
+ * aborts the process if there would be a buffer overflow, and allows for
+ * safely writing to an offset within the buffer
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer). This value should be greater than or equal to offset
+ * + count.
+ * @param offset
+ *      The number of bytes to offset the copied bytes into the destination
+ * buffer.
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @return void *
+ *      Pointer to the destination.
+ *      Note - not the offset that was written to.
+ *      TODO - may need to reconsider returning the offset as we put this into
+ * code
+ */
+
+SAFEC_API void* checked_memcpy_offset(
+    void* destination,
+    size_t destination_size,
+    size_t offset,
+    const void* source,
+    size_t count) {
+  // Naively, we could just check count > destination_size - offset. However,
+  // if offset is very large, e.g. size_t(-1), then destination_size - offset
+  // will overflow `size_t` and hence act additive to destination_size.
+  //
+  // To avoid this, we properly compute the available_size and then check that.
+
+  const size_t available_size =
+      offset > destination_size ? 0 : destination_size - offset;
+  // Only the address is traced, so compute it without pointer arithmetic,
+  // which would be undefined for an out-of-range offset.
+  SAFEC_OP(
+      checked_memcpy_offset,
+      (const void*)((uintptr_t)destination + offset),
+      source,
+      count,
+      available_size);
+
+  if (count > available_size) {
+    buffer_overflow_error_with_size(__func__, available_size, count);
+  }
+
+  SAFEC_OP_CALL(memcpy((char*)destination + offset, source, count));
+  return destination;
+}
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::memcpy that writes to an
+ * offset within the destination. This version returns an error code if there
+ * would be a buffer overflow. Error handling is mandatory. Note that using
+ * this function without error handling does not guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer). This value should be greater than or equal to offset
+ * + count.
+ * @param offset
+ *      The number of bytes to offset the copied bytes into the destination
+ * buffer.
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy_offset(
+    void* destination,
+    size_t destination_size,
+    size_t offset,
+    const void* source,
+    size_t count) {
+  // See checked_memcpy_offset for why available_size and the traced address
+  // are computed this way.
+  const size_t available_size =
+      offset > destination_size ? 0 : destination_size - offset;
+  SAFEC_OP(
+      try_checked_memcpy_offset,
+      (const void*)((uintptr_t)destination + offset),
+      source,
+      count,
+      available_size);
+
+  if (count > available_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  SAFEC_OP_CALL(memcpy((char*)destination + offset, source, count));
+  return 0;
+}
+
+/**
+ * Bounds checking (i.e. both source and destination) wrapper for std::memcpy.
+ * This version aborts the process if there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param source_size
+ *      Max number of bytes to copy from the source (typically the size of the
+ * source buffer).
+ * @param count
+ *      Number of bytes to copy.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memcpy_robust(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t source_size,
+    size_t count) {
+  SAFEC_OP(
+      checked_memcpy_robust,
+      destination,
+      source,
+      count,
+      destination_size < source_size ? destination_size : source_size);
+  if (destination_size < count || source_size < count) {
+    buffer_overflow_error(__func__);
+  }
+  return SAFEC_OP_CALL(memcpy(destination, source, count));
+}
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::memcpy. This version adds
+ * bounds checking capability and returns an error code if there's any potential
+ * buffer overflow detected. Error handling is mandatory. Note that using this
+ * function without error handling does not guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t count) {
+  SAFEC_OP(try_checked_memcpy, destination, source, count, destination_size);
+  if (destination_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  SAFEC_OP_CALL(memcpy(destination, source, count));
+  return 0;
+}
+
+/**
+ * Bounds checking (i.e. both source and destination) wrapper for std::memcpy.
+ * This version adds bounds checking capability and returns an error code if
+ * there's any potential buffer overflow detected. Error handling is mandatory.
+ * Note that using this function without error handling does not guarantee
+ * security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param source_size
+ *      Max number of bytes to copy from the source (typically the size of the
+ * source buffer).
+ * @param count
+ *      Number of bytes to copy.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy_robust(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t source_size,
+    size_t count) {
+  SAFEC_OP(
+      try_checked_memcpy_robust,
+      destination,
+      source,
+      count,
+      destination_size < source_size ? destination_size : source_size);
+  if (destination_size < count || source_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  SAFEC_OP_CALL(memcpy(destination, source, count));
+  return 0;
+}
+
+/**
+ * Truncating wrapper for std::memcpy: copies min(count, destination_size)
+ * bytes instead of failing when count does not fit. The length is computed
+ * without a branch, so data paths that want truncation need neither a retry
+ * nor an error path. This version aborts the process on null pointers.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes requested to copy.
+ * @param truncated
+ *      If not NULL, receives 1 if fewer than count bytes were copied and 0
+ * otherwise.
+ * @return size_t
+ *      Number of bytes copied.
+ */
+SAFEC_API size_t checked_memcpy_clamp(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t count,
+    int* truncated) {
+  SAFEC_OP(
+      checked_memcpy_clamp, destination, source, count, destination_size);
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  const size_t copied = count < destination_size ? count : destination_size;
+  if (truncated != BAD_PTR) {
+    *truncated = count > destination_size;
+  }
+  SAFEC_OP_CALL(memcpy(destination, source, copied));
+  return copied;
+}
+
+/*
+ * Copies count bytes, a multiple of elem_size (4, 8, 16 or 32) no larger than
+ * 64, as two possibly overlapping fixed-size blocks taken from the start and
+ * the end. Because count is a multiple of elem_size, block sizes below
+ * elem_size are never needed, so with a constant elem_size only the branches
+ * that can match survive inlining.
+ */
+static inline void safec_memcpy_elems_small(
+    unsigned char* destination,
+    const unsigned char* source,
+    size_t count,
+    size_t elem_size) {
+  if (count >= 32) {
+    memcpy(destination, source, 32);
+    memcpy(destination + count - 32, source + count - 32, 32);
+  } else if (elem_size <= 16 && count >= 16) {
+    memcpy(destination, source, 16);
+    memcpy(destination + count - 16, source + count - 16, 16);
+  } else if (elem_size <= 8 && count >= 8) {
+    memcpy(destination, source, 8);
+    memcpy(destination + count - 8, source + count - 8, 8);
+  } else if (elem_size <= 4 && count >= 4) {
+    memcpy(destination, source, 4);
+    memcpy(destination + count - 4, source + count - 4, 4);
+  }
+}
+
+/*
+ * Copies count bytes of elements of elem_size bytes. Short copies of 4, 8, 16
+ * and 32 byte elements use a few unaligned moves instead of a call into the
+ * general purpose memcpy; everything else goes to memcpy.
+ */
+static inline void* safec_memcpy_elems(
+    void* destination,
+    const void* source,
+    size_t count,
+    size_t elem_size) {
+  unsigned char* const d = (unsigned char*)destination;
+  const unsigned char* const s = (const unsigned char*)source;
+  if (count <= 64) {
+    switch (elem_size) {
+      case 4:
+        safec_memcpy_elems_small(d, s, count, 4);
+        return destination;
+      case 8:
+        safec_memcpy_elems_small(d, s, count, 8);
+        return destination;
+      case 16:
+        safec_memcpy_elems_small(d, s, count, 16);
+        return destination;
+      case 32:
+        safec_memcpy_elems_small(d, s, count, 32);
+        return destination;
+      default:
+        break;
+    }
+  }
+  return memcpy(destination, source, count);
+}
+
+/**
+ * Bounds checking wrapper for std::memcpy over arrays of elements. Sizes are
+ * given in elements, and the byte count n * elem_size is overflow-checked, so
+ * callers need not multiply by hand. This version aborts the process if
+ * there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination array.
+ * @param destination_count
+ *      Number of elements in the destination array.
+ * @param source
+ *      Pointer to the source array.
+ * @param source_count
+ *      Number of elements in the source array.
+ * @param n
+ *      Number of elements to copy.
+ * @param elem_size
+ *      Size of one element in bytes.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memcpy_elems(
+    void* destination,
+    size_t destination_count,
+    const void* source,
+    size_t source_count,
+    size_t n,
+    size_t elem_size) {
+  // The products are only reported, they are not used for the checks.
+  SAFEC_OP(
+      checked_memcpy_elems,
+      destination,
+      source,
+      n * elem_size,
+      destination_count * elem_size);
+  if (destination_count < n) {
+    buffer_overflow_error_with_size(__func__, destination_count, n);
+  }
+  if (source_count < n) {
+    buffer_oob_read_error(__func__);
+  }
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  size_t count;
+  if (try_checked_mul_size(n, elem_size, &count) != 0) {
+    integer_overflow_error(__func__);
+  }
+  return SAFEC_OP_CALL(
+      safec_memcpy_elems(destination, source, count, elem_size));
+}
+
+/**
+ * Bounds checking wrapper for std::memcpy over arrays of elements. This
+ * version returns an error code instead of aborting. Error handling is
+ * mandatory.
+ *
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_BUFFER_OVERFLOW if n exceeds
+ * either array and ERR_POTENTIAL_INTEGER_OVERFLOW if n * elem_size does not
+ * fit in size_t.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy_elems(
+    void* destination,
+    size_t destination_count,
+    const void* source,
+    size_t source_count,
+    size_t n,
+    size_t elem_size) {
+  SAFEC_OP(
+      try_checked_memcpy_elems,
+      destination,
+      source,
+      n * elem_size,
+      destination_count * elem_size);
+  if (destination_count < n || source_count < n) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  size_t count;
+  if (try_checked_mul_size(n, elem_size, &count) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  SAFEC_OP_CALL(safec_memcpy_elems(destination, source, count, elem_size));
+  return 0;
+}
+
+static inline uint16_t safec_bswap16(uint16_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap16(value);
+#else
+  return (uint16_t)((value >> 8) | (value << 8));
+#endif
+}
+
+static inline uint32_t safec_bswap32(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap32(value);
+#else
+  return ((uint32_t)safec_bswap16((uint16_t)value) << 16) |
+      safec_bswap16((uint16_t)(value >> 16));
+#endif
+}
+
+static inline uint64_t safec_bswap64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap64(value);
+#else
+  return ((uint64_t)safec_bswap32((uint32_t)value) << 32) |
+      safec_bswap32((uint32_t)(value >> 32));
+#endif
+}
+
+#if defined(__SSSE3__)
+// pshufb control that reverses the bytes of each width-byte element of a
+// 16-byte vector.
+static inline __m128i safec_bswap_shuffle(unsigned width) {
+  switch (width) {
+    case 2:
+      return _mm_setr_epi8(
+          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    case 4:
+      return _mm_setr_epi8(
+          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    default:
+      return _mm_setr_epi8(
+          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  }
+}
+#endif
+
+/*
+ * Copies count bytes of width-byte elements (2, 4 or 8) from source to
+ * destination, reversing the bytes of each element on the way. Each vector is
+ * loaded, shuffled and stored once, so the data passes through the cache a
+ * single time. destination may equal source. Returns destination.
+ */
+static inline void* safec_memcpy_bswap(
+    unsigned char* destination,
+    const unsigned char* source,
+    size_t count,
+    unsigned width) {
+  size_t i = 0;
+#if defined(__SSSE3__)
+  const __m128i shuffle = safec_bswap_shuffle(width);
+#if defined(__AVX2__)
+  const __m256i shuffle256 = _mm256_broadcastsi128_si256(shuffle);
+  for (; count - i >= 32; i += 32) {
+    const __m256i block = _mm256_loadu_si256((const __m256i*)(source + i));
+    _mm256_storeu_si256(
+        (__m256i*)(destination + i), _mm256_shuffle_epi8(block, shuffle256));
+  }
+#endif
+  for (; count - i >= 16; i += 16) {
+    const __m128i block = _mm_loadu_si128((const __m128i*)(source + i));
+    _mm_storeu_si128(
+        (__m128i*)(destination + i), _mm_shuffle_epi8(block, shuffle));
+  }
+#elif defined(__ARM_NEON)
+  for (; count - i >= 16; i += 16) {
+    const uint8x16_t block = vld1q_u8(source + i);
+    vst1q_u8(
+        destination + i,
+        width == 2       ? vrev16q_u8(block)
+            : width == 4 ? vrev32q_u8(block)
+                         : vrev64q_u8(block));
+  }
+#endif
+  for (; i < count; i += width) {
+    if (width == 2) {
+      uint16_t value;
+      memcpy(&value, source + i, 2);
+      value = safec_bswap16(value);
+      memcpy(destination + i, &value, 2);
+    } else if (width == 4) {
+      uint32_t value;
+      memcpy(&value, source + i, 4);
+      value = safec_bswap32(value);
+      memcpy(destination + i, &value, 4);
+    } else {
+      uint64_t value;
+      memcpy(&value, source + i, 8);
+      value = safec_bswap64(value);
+      memcpy(destination + i, &value, 8);
+    }
+  }
+  return destination;
+}
+
+/*
+ * Byte-swapping copies.
+ *
+ * checked_memcpy_bswap16/32/64 copy count elements of 16, 32 or 64 bits while
+ * reversing the byte order of each (e.g. host to network order), with the
+ * bounds contract of checked_memcpy: destination_size is in bytes, and
+ * count * element size is overflow-checked before it is compared against it.
+ * The swap is fused into the copy with SSSE3 or AVX2 pshufb, or NEON vrev,
+ * when the target supports it. destination may equal source for an in-place
+ * swap; other overlaps are not allowed. The aborting versions abort the
+ * process and the try_ versions return ERR_POTENTIAL_BUFFER_OVERFLOW or
+ * ERR_POTENTIAL_INTEGER_OVERFLOW.
+ */
+#define SAFEC_DEFINE_MEMCPY_BSWAP(bits)                                   \
+  SAFEC_API void* checked_memcpy_bswap##bits(                             \
+      void* destination,                                                  \
+      size_t destination_size,                                            \
+      const void* source,                                                 \
+      size_t count) {                                                     \
+    SAFEC_OP(                                                             \
+        checked_memcpy_bswap##bits,                                       \
+        destination,                                                      \
+        source,                                                           \
+        count * ((bits) / 8),                                             \
+        destination_size);                                                \
+    size_t bytes;                                                         \
+    if (try_checked_mul_size(count, (bits) / 8, &bytes) != 0) {           \
+      integer_overflow_error(__func__);                                   \
+    }                                                                     \
+    if (destination_size < bytes) {                                       \
+      buffer_overflow_error_with_size(__func__, destination_size, bytes); \
+    }                                                                     \
+    if (source == BAD_PTR || destination == BAD_PTR) {                    \
+      null_pointer_error(__func__);                                       \
+    }                                                                     \
+    SAFEC_OP_CALL(safec_memcpy_bswap(                                     \
+        (unsigned char*)destination,                                      \
+        (const unsigned char*)source,                                     \
+        bytes,                                                            \
+        (bits) / 8));                                                     \
+    return destination;                                                   \
+  }                                                                       \
+  SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int                             \
+      try_checked_memcpy_bswap##bits(                                     \
+          void* destination,                                              \
+          size_t destination_size,                                        \
+          const void* source,                                             \
+          size_t count) {                                                 \
+    SAFEC_OP(                                                             \
+        try_checked_memcpy_bswap##bits,                                   \
+        destination,                                                      \
+        source,                                                           \
+        count * ((bits) / 8),                                             \
+        destination_size);                                                \
+    size_t bytes;                                                         \
+    if (try_checked_mul_size(count, (bits) / 8, &bytes) != 0) {           \
+      return ERR_POTENTIAL_INTEGER_OVERFLOW;                              \
+    }                                                                     \
+    if (destination_size < bytes) {                                       \
+      return ERR_POTENTIAL_BUFFER_OVERFLOW;                               \
+    }                                                                     \
+    SAFEC_OP_CALL(safec_memcpy_bswap(                                     \
+        (unsigned char*)destination,                                      \
+        (const unsigned char*)source,                                     \
+        bytes,                                                            \
+        (bits) / 8));                                                     \
+    return 0;                                                             \
+  }
+
+SAFEC_DEFINE_MEMCPY_BSWAP(16)
+SAFEC_DEFINE_MEMCPY_BSWAP(32)
+SAFEC_DEFINE_MEMCPY_BSWAP(64)
+
+#undef SAFEC_DEFINE_MEMCPY_BSWAP
+
+// Slicing-by-8 tables for CRC32C (Castagnoli, reflected polynomial
+// 0x82F63B78). Row k holds the CRC contribution of a byte that is followed by
+// k more bytes.
+static const uint32_t safec_crc32c_table[8][256] = {
+    {
+        0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+        0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+        0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+        0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+        0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+        0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+        0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+        0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+        0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+        0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+        0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+        0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+        0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+        0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+        0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+        0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+        0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+        0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+        0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+        0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+        0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+        0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+        0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+        0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+        0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+        0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+        0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+        0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+        0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+        0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+        0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+        0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+        0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+        0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+        0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+        0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+        0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+        0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+        0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+        0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+        0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+        0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+        0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351
+    },
+    {
+        0x00000000, 0x13a29877, 0x274530ee, 0x34e7a899, 0x4e8a61dc, 0x5d28f9ab,
+        0x69cf5132, 0x7a6dc945, 0x9d14c3b8, 0x8eb65bcf, 0xba51f356, 0xa9f36b21,
+        0xd39ea264, 0xc03c3a13, 0xf4db928a, 0xe7790afd, 0x3fc5f181, 0x2c6769f6,
+        0x1880c16f, 0x0b225918, 0x714f905d, 0x62ed082a, 0x560aa0b3, 0x45a838c4,
+        0xa2d13239, 0xb173aa4e, 0x859402d7, 0x96369aa0, 0xec5b53e5, 0xfff9cb92,
+        0xcb1e630b, 0xd8bcfb7c, 0x7f8be302, 0x6c297b75, 0x58ced3ec, 0x4b6c4b9b,
+        0x310182de, 0x22a31aa9, 0x1644b230, 0x05e62a47, 0xe29f20ba, 0xf13db8cd,
+        0xc5da1054, 0xd6788823, 0xac154166, 0xbfb7d911, 0x8b507188, 0x98f2e9ff,
+        0x404e1283, 0x53ec8af4, 0x670b226d, 0x74a9ba1a, 0x0ec4735f, 0x1d66eb28,
+        0x298143b1, 0x3a23dbc6, 0xdd5ad13b, 0xcef8494c, 0xfa1fe1d5, 0xe9bd79a2,
+        0x93d0b0e7, 0x80722890, 0xb4958009, 0xa737187e, 0xff17c604, 0xecb55e73,
+        0xd852f6ea, 0xcbf06e9d, 0xb19da7d8, 0xa23f3faf, 0x96d89736, 0x857a0f41,
+        0x620305bc, 0x71a19dcb, 0x45463552, 0x56e4ad25, 0x2c896460, 0x3f2bfc17,
+        0x0bcc548e, 0x186eccf9, 0xc0d23785, 0xd370aff2, 0xe797076b, 0xf4359f1c,
+        0x8e585659, 0x9dface2e, 0xa91d66b7, 0xbabffec0, 0x5dc6f43d, 0x4e646c4a,
+        0x7a83c4d3, 0x69215ca4, 0x134c95e1, 0x00ee0d96, 0x3409a50f, 0x27ab3d78,
+        0x809c2506, 0x933ebd71, 0xa7d915e8, 0xb47b8d9f, 0xce1644da, 0xddb4dcad,
+        0xe9537434, 0xfaf1ec43, 0x1d88e6be, 0x0e2a7ec9, 0x3acdd650, 0x296f4e27,
+        0x53028762, 0x40a01f15, 0x7447b78c, 0x67e52ffb, 0xbf59d487, 0xacfb4cf0,
+        0x981ce469, 0x8bbe7c1e, 0xf1d3b55b, 0xe2712d2c, 0xd69685b5, 0xc5341dc2,
+        0x224d173f, 0x31ef8f48, 0x050827d1, 0x16aabfa6, 0x6cc776e3, 0x7f65ee94,
+        0x4b82460d, 0x5820de7a, 0xfbc3faf9, 0xe861628e, 0xdc86ca17, 0xcf245260,
+        0xb5499b25, 0xa6eb0352, 0x920cabcb, 0x81ae33bc, 0x66d73941, 0x7575a136,
+        0x419209af, 0x523091d8, 0x285d589d, 0x3bffc0ea, 0x0f186873, 0x1cbaf004,
+        0xc4060b78, 0xd7a4930f, 0xe3433b96, 0xf0e1a3e1, 0x8a8c6aa4, 0x992ef2d3,
+        0xadc95a4a, 0xbe6bc23d, 0x5912c8c0, 0x4ab050b7, 0x7e57f82e, 0x6df56059,
+        0x1798a91c, 0x043a316b, 0x30dd99f2, 0x237f0185, 0x844819fb, 0x97ea818c,
+        0xa30d2915, 0xb0afb162, 0xcac27827, 0xd960e050, 0xed8748c9, 0xfe25d0be,
+        0x195cda43, 0x0afe4234, 0x3e19eaad, 0x2dbb72da, 0x57d6bb9f, 0x447423e8,
+        0x70938b71, 0x63311306, 0xbb8de87a, 0xa82f700d, 0x9cc8d894, 0x8f6a40e3,
+        0xf50789a6, 0xe6a511d1, 0xd242b948, 0xc1e0213f, 0x26992bc2, 0x353bb3b5,
+        0x01dc1b2c, 0x127e835b, 0x68134a1e, 0x7bb1d269, 0x4f567af0, 0x5cf4e287,
+        0x04d43cfd, 0x1776a48a, 0x23910c13, 0x30339464, 0x4a5e5d21, 0x59fcc556,
+        0x6d1b6dcf, 0x7eb9f5b8, 0x99c0ff45, 0x8a626732, 0xbe85cfab, 0xad2757dc,
+        0xd74a9e99, 0xc4e806ee, 0xf00fae77, 0xe3ad3600, 0x3b11cd7c, 0x28b3550b,
+        0x1c54fd92, 0x0ff665e5, 0x759baca0, 0x663934d7, 0x52de9c4e, 0x417c0439,
+        0xa6050ec4, 0xb5a796b3, 0x81403e2a, 0x92e2a65d, 0xe88f6f18, 0xfb2df76f,
+        0xcfca5ff6, 0xdc68c781, 0x7b5fdfff, 0x68fd4788, 0x5c1aef11, 0x4fb87766,
+        0x35d5be23, 0x26772654, 0x12908ecd, 0x013216ba, 0xe64b1c47, 0xf5e98430,
+        0xc10e2ca9, 0xd2acb4de, 0xa8c17d9b, 0xbb63e5ec, 0x8f844d75, 0x9c26d502,
+        0x449a2e7e, 0x5738b609, 0x63df1e90, 0x707d86e7, 0x0a104fa2, 0x19b2d7d5,
+        0x2d557f4c, 0x3ef7e73b, 0xd98eedc6, 0xca2c75b1, 0xfecbdd28, 0xed69455f,
+        0x97048c1a, 0x84a6146d, 0xb041bcf4, 0xa3e32483
+    },
+    {
+        0x00000000, 0xa541927e, 0x4f6f520d, 0xea2ec073, 0x9edea41a, 0x3b9f3664,
+        0xd1b1f617, 0x74f06469, 0x38513ec5, 0x9d10acbb, 0x773e6cc8, 0xd27ffeb6,
+        0xa68f9adf, 0x03ce08a1, 0xe9e0c8d2, 0x4ca15aac, 0x70a27d8a, 0xd5e3eff4,
+        0x3fcd2f87, 0x9a8cbdf9, 0xee7cd990, 0x4b3d4bee, 0xa1138b9d, 0x045219e3,
+        0x48f3434f, 0xedb2d131, 0x079c1142, 0xa2dd833c, 0xd62de755, 0x736c752b,
+        0x9942b558, 0x3c032726, 0xe144fb14, 0x4405696a, 0xae2ba919, 0x0b6a3b67,
+        0x7f9a5f0e, 0xdadbcd70, 0x30f50d03, 0x95b49f7d, 0xd915c5d1, 0x7c5457af,
+        0x967a97dc, 0x333b05a2, 0x47cb61cb, 0xe28af3b5, 0x08a433c6, 0xade5a1b8,
+        0x91e6869e, 0x34a714e0, 0xde89d493, 0x7bc846ed, 0x0f382284, 0xaa79b0fa,
+        0x40577089, 0xe516e2f7, 0xa9b7b85b, 0x0cf62a25, 0xe6d8ea56, 0x43997828,
+        0x37691c41, 0x92288e3f, 0x78064e4c, 0xdd47dc32, 0xc76580d9, 0x622412a7,
+        0x880ad2d4, 0x2d4b40aa, 0x59bb24c3, 0xfcfab6bd, 0x16d476ce, 0xb395e4b0,
+        0xff34be1c, 0x5a752c62, 0xb05bec11, 0x151a7e6f, 0x61ea1a06, 0xc4ab8878,
+        0x2e85480b, 0x8bc4da75, 0xb7c7fd53, 0x12866f2d, 0xf8a8af5e, 0x5de93d20,
+        0x29195949, 0x8c58cb37, 0x66760b44, 0xc337993a, 0x8f96c396, 0x2ad751e8,
+        0xc0f9919b, 0x65b803e5, 0x1148678c, 0xb409f5f2, 0x5e273581, 0xfb66a7ff,
+        0x26217bcd, 0x8360e9b3, 0x694e29c0, 0xcc0fbbbe, 0xb8ffdfd7, 0x1dbe4da9,
+        0xf7908dda, 0x52d11fa4, 0x1e704508, 0xbb31d776, 0x511f1705, 0xf45e857b,
+        0x80aee112, 0x25ef736c, 0xcfc1b31f, 0x6a802161, 0x56830647, 0xf3c29439,
+        0x19ec544a, 0xbcadc634, 0xc85da25d, 0x6d1c3023, 0x8732f050, 0x2273622e,
+        0x6ed23882, 0xcb93aafc, 0x21bd6a8f, 0x84fcf8f1, 0xf00c9c98, 0x554d0ee6,
+        0xbf63ce95, 0x1a225ceb, 0x8b277743, 0x2e66e53d, 0xc448254e, 0x6109b730,
+        0x15f9d359, 0xb0b84127, 0x5a968154, 0xffd7132a, 0xb3764986, 0x1637dbf8,
+        0xfc191b8b, 0x595889f5, 0x2da8ed9c, 0x88e97fe2, 0x62c7bf91, 0xc7862def,
+        0xfb850ac9, 0x5ec498b7, 0xb4ea58c4, 0x11abcaba, 0x655baed3, 0xc01a3cad,
+        0x2a34fcde, 0x8f756ea0, 0xc3d4340c, 0x6695a672, 0x8cbb6601, 0x29faf47f,
+        0x5d0a9016, 0xf84b0268, 0x1265c21b, 0xb7245065, 0x6a638c57, 0xcf221e29,
+        0x250cde5a, 0x804d4c24, 0xf4bd284d, 0x51fcba33, 0xbbd27a40, 0x1e93e83e,
+        0x5232b292, 0xf77320ec, 0x1d5de09f, 0xb81c72e1, 0xccec1688, 0x69ad84f6,
+        0x83834485, 0x26c2d6fb, 0x1ac1f1dd, 0xbf8063a3, 0x55aea3d0, 0xf0ef31ae,
+        0x841f55c7, 0x215ec7b9, 0xcb7007ca, 0x6e3195b4, 0x2290cf18, 0x87d15d66,
+        0x6dff9d15, 0xc8be0f6b, 0xbc4e6b02, 0x190ff97c, 0xf321390f, 0x5660ab71,
+        0x4c42f79a, 0xe90365e4, 0x032da597, 0xa66c37e9, 0xd29c5380, 0x77ddc1fe,
+        0x9df3018d, 0x38b293f3, 0x7413c95f, 0xd1525b21, 0x3b7c9b52, 0x9e3d092c,
+        0xeacd6d45, 0x4f8cff3b, 0xa5a23f48, 0x00e3ad36, 0x3ce08a10, 0x99a1186e,
+        0x738fd81d, 0xd6ce4a63, 0xa23e2e0a, 0x077fbc74, 0xed517c07, 0x4810ee79,
+        0x04b1b4d5, 0xa1f026ab, 0x4bdee6d8, 0xee9f74a6, 0x9a6f10cf, 0x3f2e82b1,
+        0xd50042c2, 0x7041d0bc, 0xad060c8e, 0x08479ef0, 0xe2695e83, 0x4728ccfd,
+        0x33d8a894, 0x96993aea, 0x7cb7fa99, 0xd9f668e7, 0x9557324b, 0x3016a035,
+        0xda386046, 0x7f79f238, 0x0b899651, 0xaec8042f, 0x44e6c45c, 0xe1a75622,
+        0xdda47104, 0x78e5e37a, 0x92cb2309, 0x378ab177, 0x437ad51e, 0xe63b4760,
+        0x0c158713, 0xa954156d, 0xe5f54fc1, 0x40b4ddbf, 0xaa9a1dcc, 0x0fdb8fb2,
+        0x7b2bebdb, 0xde6a79a5, 0x3444b9d6, 0x91052ba8
+    },
+    {
+        0x00000000, 0xdd45aab8, 0xbf672381, 0x62228939, 0x7b2231f3, 0xa6679b4b,
+        0xc4451272, 0x1900b8ca, 0xf64463e6, 0x2b01c95e, 0x49234067, 0x9466eadf,
+        0x8d665215, 0x5023f8ad, 0x32017194, 0xef44db2c, 0xe964b13d, 0x34211b85,
+        0x560392bc, 0x8b463804, 0x924680ce, 0x4f032a76, 0x2d21a34f, 0xf06409f7,
+        0x1f20d2db, 0xc2657863, 0xa047f15a, 0x7d025be2, 0x6402e328, 0xb9474990,
+        0xdb65c0a9, 0x06206a11, 0xd725148b, 0x0a60be33, 0x6842370a, 0xb5079db2,
+        0xac072578, 0x71428fc0, 0x136006f9, 0xce25ac41, 0x2161776d, 0xfc24ddd5,
+        0x9e0654ec, 0x4343fe54, 0x5a43469e, 0x8706ec26, 0xe524651f, 0x3861cfa7,
+        0x3e41a5b6, 0xe3040f0e, 0x81268637, 0x5c632c8f, 0x45639445, 0x98263efd,
+        0xfa04b7c4, 0x27411d7c, 0xc805c650, 0x15406ce8, 0x7762e5d1, 0xaa274f69,
+        0xb327f7a3, 0x6e625d1b, 0x0c40d422, 0xd1057e9a, 0xaba65fe7, 0x76e3f55f,
+        0x14c17c66, 0xc984d6de, 0xd0846e14, 0x0dc1c4ac, 0x6fe34d95, 0xb2a6e72d,
+        0x5de23c01, 0x80a796b9, 0xe2851f80, 0x3fc0b538, 0x26c00df2, 0xfb85a74a,
+        0x99a72e73, 0x44e284cb, 0x42c2eeda, 0x9f874462, 0xfda5cd5b, 0x20e067e3,
+        0x39e0df29, 0xe4a57591, 0x8687fca8, 0x5bc25610, 0xb4868d3c, 0x69c32784,
+        0x0be1aebd, 0xd6a40405, 0xcfa4bccf, 0x12e11677, 0x70c39f4e, 0xad8635f6,
+        0x7c834b6c, 0xa1c6e1d4, 0xc3e468ed, 0x1ea1c255, 0x07a17a9f, 0xdae4d027,
+        0xb8c6591e, 0x6583f3a6, 0x8ac7288a, 0x57828232, 0x35a00b0b, 0xe8e5a1b3,
+        0xf1e51979, 0x2ca0b3c1, 0x4e823af8, 0x93c79040, 0x95e7fa51, 0x48a250e9,
+        0x2a80d9d0, 0xf7c57368, 0xeec5cba2, 0x3380611a, 0x51a2e823, 0x8ce7429b,
+        0x63a399b7, 0xbee6330f, 0xdcc4ba36, 0x0181108e, 0x1881a844, 0xc5c402fc,
+        0xa7e68bc5, 0x7aa3217d, 0x52a0c93f, 0x8fe56387, 0xedc7eabe, 0x30824006,
+        0x2982f8cc, 0xf4c75274, 0x96e5db4d, 0x4ba071f5, 0xa4e4aad9, 0x79a10061,
+        0x1b838958, 0xc6c623e0, 0xdfc69b2a, 0x02833192, 0x60a1b8ab, 0xbde41213,
+        0xbbc47802, 0x6681d2ba, 0x04a35b83, 0xd9e6f13b, 0xc0e649f1, 0x1da3e349,
+        0x7f816a70, 0xa2c4c0c8, 0x4d801be4, 0x90c5b15c, 0xf2e73865, 0x2fa292dd,
+        0x36a22a17, 0xebe780af, 0x89c50996, 0x5480a32e, 0x8585ddb4, 0x58c0770c,
+        0x3ae2fe35, 0xe7a7548d, 0xfea7ec47, 0x23e246ff, 0x41c0cfc6, 0x9c85657e,
+        0x73c1be52, 0xae8414ea, 0xcca69dd3, 0x11e3376b, 0x08e38fa1, 0xd5a62519,
+        0xb784ac20, 0x6ac10698, 0x6ce16c89, 0xb1a4c631, 0xd3864f08, 0x0ec3e5b0,
+        0x17c35d7a, 0xca86f7c2, 0xa8a47efb, 0x75e1d443, 0x9aa50f6f, 0x47e0a5d7,
+        0x25c22cee, 0xf8878656, 0xe1873e9c, 0x3cc29424, 0x5ee01d1d, 0x83a5b7a5,
+        0xf90696d8, 0x24433c60, 0x4661b559, 0x9b241fe1, 0x8224a72b, 0x5f610d93,
+        0x3d4384aa, 0xe0062e12, 0x0f42f53e, 0xd2075f86, 0xb025d6bf, 0x6d607c07,
+        0x7460c4cd, 0xa9256e75, 0xcb07e74c, 0x16424df4, 0x106227e5, 0xcd278d5d,
+        0xaf050464, 0x7240aedc, 0x6b401616, 0xb605bcae, 0xd4273597, 0x09629f2f,
+        0xe6264403, 0x3b63eebb, 0x59416782, 0x8404cd3a, 0x9d0475f0, 0x4041df48,
+        0x22635671, 0xff26fcc9, 0x2e238253, 0xf36628eb, 0x9144a1d2, 0x4c010b6a,
+        0x5501b3a0, 0x88441918, 0xea669021, 0x37233a99, 0xd867e1b5, 0x05224b0d,
+        0x6700c234, 0xba45688c, 0xa345d046, 0x7e007afe, 0x1c22f3c7, 0xc167597f,
+        0xc747336e, 0x1a0299d6, 0x782010ef, 0xa565ba57, 0xbc65029d, 0x6120a825,
+        0x0302211c, 0xde478ba4, 0x31035088, 0xec46fa30, 0x8e647309, 0x5321d9b1,
+        0x4a21617b, 0x9764cbc3, 0xf54642fa, 0x2803e842
+    },
+    {
+        0x00000000, 0x38116fac, 0x7022df58, 0x4833b0f4, 0xe045beb0, 0xd854d11c,
+        0x906761e8, 0xa8760e44, 0xc5670b91, 0xfd76643d, 0xb545d4c9, 0x8d54bb65,
+        0x2522b521, 0x1d33da8d, 0x55006a79, 0x6d1105d5, 0x8f2261d3, 0xb7330e7f,
+        0xff00be8b, 0xc711d127, 0x6f67df63, 0x5776b0cf, 0x1f45003b, 0x27546f97,
+        0x4a456a42, 0x725405ee, 0x3a67b51a, 0x0276dab6, 0xaa00d4f2, 0x9211bb5e,
+        0xda220baa, 0xe2336406, 0x1ba8b557, 0x23b9dafb, 0x6b8a6a0f, 0x539b05a3,
+        0xfbed0be7, 0xc3fc644b, 0x8bcfd4bf, 0xb3debb13, 0xdecfbec6, 0xe6ded16a,
+        0xaeed619e, 0x96fc0e32, 0x3e8a0076, 0x069b6fda, 0x4ea8df2e, 0x76b9b082,
+        0x948ad484, 0xac9bbb28, 0xe4a80bdc, 0xdcb96470, 0x74cf6a34, 0x4cde0598,
+        0x04edb56c, 0x3cfcdac0, 0x51eddf15, 0x69fcb0b9, 0x21cf004d, 0x19de6fe1,
+        0xb1a861a5, 0x89b90e09, 0xc18abefd, 0xf99bd151, 0x37516aae, 0x0f400502,
+        0x4773b5f6, 0x7f62da5a, 0xd714d41e, 0xef05bbb2, 0xa7360b46, 0x9f2764ea,
+        0xf236613f, 0xca270e93, 0x8214be67, 0xba05d1cb, 0x1273df8f, 0x2a62b023,
+        0x625100d7, 0x5a406f7b, 0xb8730b7d, 0x806264d1, 0xc851d425, 0xf040bb89,
+        0x5836b5cd, 0x6027da61, 0x28146a95, 0x10050539, 0x7d1400ec, 0x45056f40,
+        0x0d36dfb4, 0x3527b018, 0x9d51be5c, 0xa540d1f0, 0xed736104, 0xd5620ea8,
+        0x2cf9dff9, 0x14e8b055, 0x5cdb00a1, 0x64ca6f0d, 0xccbc6149, 0xf4ad0ee5,
+        0xbc9ebe11, 0x848fd1bd, 0xe99ed468, 0xd18fbbc4, 0x99bc0b30, 0xa1ad649c,
+        0x09db6ad8, 0x31ca0574, 0x79f9b580, 0x41e8da2c, 0xa3dbbe2a, 0x9bcad186,
+        0xd3f96172, 0xebe80ede, 0x439e009a, 0x7b8f6f36, 0x33bcdfc2, 0x0badb06e,
+        0x66bcb5bb, 0x5eadda17, 0x169e6ae3, 0x2e8f054f, 0x86f90b0b, 0xbee864a7,
+        0xf6dbd453, 0xcecabbff, 0x6ea2d55c, 0x56b3baf0, 0x1e800a04, 0x269165a8,
+        0x8ee76bec, 0xb6f60440, 0xfec5b4b4, 0xc6d4db18, 0xabc5decd, 0x93d4b161,
+        0xdbe70195, 0xe3f66e39, 0x4b80607d, 0x73910fd1, 0x3ba2bf25, 0x03b3d089,
+        0xe180b48f, 0xd991db23, 0x91a26bd7, 0xa9b3047b, 0x01c50a3f, 0x39d46593,
+        0x71e7d567, 0x49f6bacb, 0x24e7bf1e, 0x1cf6d0b2, 0x54c56046, 0x6cd40fea,
+        0xc4a201ae, 0xfcb36e02, 0xb480def6, 0x8c91b15a, 0x750a600b, 0x4d1b0fa7,
+        0x0528bf53, 0x3d39d0ff, 0x954fdebb, 0xad5eb117, 0xe56d01e3, 0xdd7c6e4f,
+        0xb06d6b9a, 0x887c0436, 0xc04fb4c2, 0xf85edb6e, 0x5028d52a, 0x6839ba86,
+        0x200a0a72, 0x181b65de, 0xfa2801d8, 0xc2396e74, 0x8a0ade80, 0xb21bb12c,
+        0x1a6dbf68, 0x227cd0c4, 0x6a4f6030, 0x525e0f9c, 0x3f4f0a49, 0x075e65e5,
+        0x4f6dd511, 0x777cbabd, 0xdf0ab4f9, 0xe71bdb55, 0xaf286ba1, 0x9739040d,
+        0x59f3bff2, 0x61e2d05e, 0x29d160aa, 0x11c00f06, 0xb9b60142, 0x81a76eee,
+        0xc994de1a, 0xf185b1b6, 0x9c94b463, 0xa485dbcf, 0xecb66b3b, 0xd4a70497,
+        0x7cd10ad3, 0x44c0657f, 0x0cf3d58b, 0x34e2ba27, 0xd6d1de21, 0xeec0b18d,
+        0xa6f30179, 0x9ee26ed5, 0x36946091, 0x0e850f3d, 0x46b6bfc9, 0x7ea7d065,
+        0x13b6d5b0, 0x2ba7ba1c, 0x63940ae8, 0x5b856544, 0xf3f36b00, 0xcbe204ac,
+        0x83d1b458, 0xbbc0dbf4, 0x425b0aa5, 0x7a4a6509, 0x3279d5fd, 0x0a68ba51,
+        0xa21eb415, 0x9a0fdbb9, 0xd23c6b4d, 0xea2d04e1, 0x873c0134, 0xbf2d6e98,
+        0xf71ede6c, 0xcf0fb1c0, 0x6779bf84, 0x5f68d028, 0x175b60dc, 0x2f4a0f70,
+        0xcd796b76, 0xf56804da, 0xbd5bb42e, 0x854adb82, 0x2d3cd5c6, 0x152dba6a,
+        0x5d1e0a9e, 0x650f6532, 0x081e60e7, 0x300f0f4b, 0x783cbfbf, 0x402dd013,
+        0xe85bde57, 0xd04ab1fb, 0x9879010f, 0xa0686ea3
+    },
+    {
+        0x00000000, 0xef306b19, 0xdb8ca0c3, 0x34bccbda, 0xb2f53777, 0x5dc55c6e,
+        0x697997b4, 0x8649fcad, 0x6006181f, 0x8f367306, 0xbb8ab8dc, 0x54bad3c5,
+        0xd2f32f68, 0x3dc34471, 0x097f8fab, 0xe64fe4b2, 0xc00c303e, 0x2f3c5b27,
+        0x1b8090fd, 0xf4b0fbe4, 0x72f90749, 0x9dc96c50, 0xa975a78a, 0x4645cc93,
+        0xa00a2821, 0x4f3a4338, 0x7b8688e2, 0x94b6e3fb, 0x12ff1f56, 0xfdcf744f,
+        0xc973bf95, 0x2643d48c, 0x85f4168d, 0x6ac47d94, 0x5e78b64e, 0xb148dd57,
+        0x370121fa, 0xd8314ae3, 0xec8d8139, 0x03bdea20, 0xe5f20e92, 0x0ac2658b,
+        0x3e7eae51, 0xd14ec548, 0x570739e5, 0xb83752fc, 0x8c8b9926, 0x63bbf23f,
+        0x45f826b3, 0xaac84daa, 0x9e748670, 0x7144ed69, 0xf70d11c4, 0x183d7add,
+        0x2c81b107, 0xc3b1da1e, 0x25fe3eac, 0xcace55b5, 0xfe729e6f, 0x1142f576,
+        0x970b09db, 0x783b62c2, 0x4c87a918, 0xa3b7c201, 0x0e045beb, 0xe13430f2,
+        0xd588fb28, 0x3ab89031, 0xbcf16c9c, 0x53c10785, 0x677dcc5f, 0x884da746,
+        0x6e0243f4, 0x813228ed, 0xb58ee337, 0x5abe882e, 0xdcf77483, 0x33c71f9a,
+        0x077bd440, 0xe84bbf59, 0xce086bd5, 0x213800cc, 0x1584cb16, 0xfab4a00f,
+        0x7cfd5ca2, 0x93cd37bb, 0xa771fc61, 0x48419778, 0xae0e73ca, 0x413e18d3,
+        0x7582d309, 0x9ab2b810, 0x1cfb44bd, 0xf3cb2fa4, 0xc777e47e, 0x28478f67,
+        0x8bf04d66, 0x64c0267f, 0x507ceda5, 0xbf4c86bc, 0x39057a11, 0xd6351108,
+        0xe289dad2, 0x0db9b1cb, 0xebf65579, 0x04c63e60, 0x307af5ba, 0xdf4a9ea3,
+        0x5903620e, 0xb6330917, 0x828fc2cd, 0x6dbfa9d4, 0x4bfc7d58, 0xa4cc1641,
+        0x9070dd9b, 0x7f40b682, 0xf9094a2f, 0x16392136, 0x2285eaec, 0xcdb581f5,
+        0x2bfa6547, 0xc4ca0e5e, 0xf076c584, 0x1f46ae9d, 0x990f5230, 0x763f3929,
+        0x4283f2f3, 0xadb399ea, 0x1c08b7d6, 0xf338dccf, 0xc7841715, 0x28b47c0c,
+        0xaefd80a1, 0x41cdebb8, 0x75712062, 0x9a414b7b, 0x7c0eafc9, 0x933ec4d0,
+        0xa7820f0a, 0x48b26413, 0xcefb98be, 0x21cbf3a7, 0x1577387d, 0xfa475364,
+        0xdc0487e8, 0x3334ecf1, 0x0788272b, 0xe8b84c32, 0x6ef1b09f, 0x81c1db86,
+        0xb57d105c, 0x5a4d7b45, 0xbc029ff7, 0x5332f4ee, 0x678e3f34, 0x88be542d,
+        0x0ef7a880, 0xe1c7c399, 0xd57b0843, 0x3a4b635a, 0x99fca15b, 0x76ccca42,
+        0x42700198, 0xad406a81, 0x2b09962c, 0xc439fd35, 0xf08536ef, 0x1fb55df6,
+        0xf9fab944, 0x16cad25d, 0x22761987, 0xcd46729e, 0x4b0f8e33, 0xa43fe52a,
+        0x90832ef0, 0x7fb345e9, 0x59f09165, 0xb6c0fa7c, 0x827c31a6, 0x6d4c5abf,
+        0xeb05a612, 0x0435cd0b, 0x308906d1, 0xdfb96dc8, 0x39f6897a, 0xd6c6e263,
+        0xe27a29b9, 0x0d4a42a0, 0x8b03be0d, 0x6433d514, 0x508f1ece, 0xbfbf75d7,
+        0x120cec3d, 0xfd3c8724, 0xc9804cfe, 0x26b027e7, 0xa0f9db4a, 0x4fc9b053,
+        0x7b757b89, 0x94451090, 0x720af422, 0x9d3a9f3b, 0xa98654e1, 0x46b63ff8,
+        0xc0ffc355, 0x2fcfa84c, 0x1b736396, 0xf443088f, 0xd200dc03, 0x3d30b71a,
+        0x098c7cc0, 0xe6bc17d9, 0x60f5eb74, 0x8fc5806d, 0xbb794bb7, 0x544920ae,
+        0xb206c41c, 0x5d36af05, 0x698a64df, 0x86ba0fc6, 0x00f3f36b, 0xefc39872,
+        0xdb7f53a8, 0x344f38b1, 0x97f8fab0, 0x78c891a9, 0x4c745a73, 0xa344316a,
+        0x250dcdc7, 0xca3da6de, 0xfe816d04, 0x11b1061d, 0xf7fee2af, 0x18ce89b6,
+        0x2c72426c, 0xc3422975, 0x450bd5d8, 0xaa3bbec1, 0x9e87751b, 0x71b71e02,
+        0x57f4ca8e, 0xb8c4a197, 0x8c786a4d, 0x63480154, 0xe501fdf9, 0x0a3196e0,
+        0x3e8d5d3a, 0xd1bd3623, 0x37f2d291, 0xd8c2b988, 0xec7e7252, 0x034e194b,
+        0x8507e5e6, 0x6a378eff, 0x5e8b4525, 0xb1bb2e3c
+    },
+    {
+        0x00000000, 0x68032cc8, 0xd0065990, 0xb8057558, 0xa5e0c5d1, 0xcde3e919,
+        0x75e69c41, 0x1de5b089, 0x4e2dfd53, 0x262ed19b, 0x9e2ba4c3, 0xf628880b,
+        0xebcd3882, 0x83ce144a, 0x3bcb6112, 0x53c84dda, 0x9c5bfaa6, 0xf458d66e,
+        0x4c5da336, 0x245e8ffe, 0x39bb3f77, 0x51b813bf, 0xe9bd66e7, 0x81be4a2f,
+        0xd27607f5, 0xba752b3d, 0x02705e65, 0x6a7372ad, 0x7796c224, 0x1f95eeec,
+        0xa7909bb4, 0xcf93b77c, 0x3d5b83bd, 0x5558af75, 0xed5dda2d, 0x855ef6e5,
+        0x98bb466c, 0xf0b86aa4, 0x48bd1ffc, 0x20be3334, 0x73767eee, 0x1b755226,
+        0xa370277e, 0xcb730bb6, 0xd696bb3f, 0xbe9597f7, 0x0690e2af, 0x6e93ce67,
+        0xa100791b, 0xc90355d3, 0x7106208b, 0x19050c43, 0x04e0bcca, 0x6ce39002,
+        0xd4e6e55a, 0xbce5c992, 0xef2d8448, 0x872ea880, 0x3f2bddd8, 0x5728f110,
+        0x4acd4199, 0x22ce6d51, 0x9acb1809, 0xf2c834c1, 0x7ab7077a, 0x12b42bb2,
+        0xaab15eea, 0xc2b27222, 0xdf57c2ab, 0xb754ee63, 0x0f519b3b, 0x6752b7f3,
+        0x349afa29, 0x5c99d6e1, 0xe49ca3b9, 0x8c9f8f71, 0x917a3ff8, 0xf9791330,
+        0x417c6668, 0x297f4aa0, 0xe6ecfddc, 0x8eefd114, 0x36eaa44c, 0x5ee98884,
+        0x430c380d, 0x2b0f14c5, 0x930a619d, 0xfb094d55, 0xa8c1008f, 0xc0c22c47,
+        0x78c7591f, 0x10c475d7, 0x0d21c55e, 0x6522e996, 0xdd279cce, 0xb524b006,
+        0x47ec84c7, 0x2fefa80f, 0x97eadd57, 0xffe9f19f, 0xe20c4116, 0x8a0f6dde,
+        0x320a1886, 0x5a09344e, 0x09c17994, 0x61c2555c, 0xd9c72004, 0xb1c40ccc,
+        0xac21bc45, 0xc422908d, 0x7c27e5d5, 0x1424c91d, 0xdbb77e61, 0xb3b452a9,
+        0x0bb127f1, 0x63b20b39, 0x7e57bbb0, 0x16549778, 0xae51e220, 0xc652cee8,
+        0x959a8332, 0xfd99affa, 0x459cdaa2, 0x2d9ff66a, 0x307a46e3, 0x58796a2b,
+        0xe07c1f73, 0x887f33bb, 0xf56e0ef4, 0x9d6d223c, 0x25685764, 0x4d6b7bac,
+        0x508ecb25, 0x388de7ed, 0x808892b5, 0xe88bbe7d, 0xbb43f3a7, 0xd340df6f,
+        0x6b45aa37, 0x034686ff, 0x1ea33676, 0x76a01abe, 0xcea56fe6, 0xa6a6432e,
+        0x6935f452, 0x0136d89a, 0xb933adc2, 0xd130810a, 0xccd53183, 0xa4d61d4b,
+        0x1cd36813, 0x74d044db, 0x27180901, 0x4f1b25c9, 0xf71e5091, 0x9f1d7c59,
+        0x82f8ccd0, 0xeafbe018, 0x52fe9540, 0x3afdb988, 0xc8358d49, 0xa036a181,
+        0x1833d4d9, 0x7030f811, 0x6dd54898, 0x05d66450, 0xbdd31108, 0xd5d03dc0,
+        0x8618701a, 0xee1b5cd2, 0x561e298a, 0x3e1d0542, 0x23f8b5cb, 0x4bfb9903,
+        0xf3feec5b, 0x9bfdc093, 0x546e77ef, 0x3c6d5b27, 0x84682e7f, 0xec6b02b7,
+        0xf18eb23e, 0x998d9ef6, 0x2188ebae, 0x498bc766, 0x1a438abc, 0x7240a674,
+        0xca45d32c, 0xa246ffe4, 0xbfa34f6d, 0xd7a063a5, 0x6fa516fd, 0x07a63a35,
+        0x8fd9098e, 0xe7da2546, 0x5fdf501e, 0x37dc7cd6, 0x2a39cc5f, 0x423ae097,
+        0xfa3f95cf, 0x923cb907, 0xc1f4f4dd, 0xa9f7d815, 0x11f2ad4d, 0x79f18185,
+        0x6414310c, 0x0c171dc4, 0xb412689c, 0xdc114454, 0x1382f328, 0x7b81dfe0,
+        0xc384aab8, 0xab878670, 0xb66236f9, 0xde611a31, 0x66646f69, 0x0e6743a1,
+        0x5daf0e7b, 0x35ac22b3, 0x8da957eb, 0xe5aa7b23, 0xf84fcbaa, 0x904ce762,
+        0x2849923a, 0x404abef2, 0xb2828a33, 0xda81a6fb, 0x6284d3a3, 0x0a87ff6b,
+        0x17624fe2, 0x7f61632a, 0xc7641672, 0xaf673aba, 0xfcaf7760, 0x94ac5ba8,
+        0x2ca92ef0, 0x44aa0238, 0x594fb2b1, 0x314c9e79, 0x8949eb21, 0xe14ac7e9,
+        0x2ed97095, 0x46da5c5d, 0xfedf2905, 0x96dc05cd, 0x8b39b544, 0xe33a998c,
+        0x5b3fecd4, 0x333cc01c, 0x60f48dc6, 0x08f7a10e, 0xb0f2d456, 0xd8f1f89e,
+        0xc5144817, 0xad1764df, 0x15121187, 0x7d113d4f
+    },
+    {
+        0x00000000, 0x493c7d27, 0x9278fa4e, 0xdb448769, 0x211d826d, 0x6821ff4a,
+        0xb3657823, 0xfa590504, 0x423b04da, 0x0b0779fd, 0xd043fe94, 0x997f83b3,
+        0x632686b7, 0x2a1afb90, 0xf15e7cf9, 0xb86201de, 0x847609b4, 0xcd4a7493,
+        0x160ef3fa, 0x5f328edd, 0xa56b8bd9, 0xec57f6fe, 0x37137197, 0x7e2f0cb0,
+        0xc64d0d6e, 0x8f717049, 0x5435f720, 0x1d098a07, 0xe7508f03, 0xae6cf224,
+        0x7528754d, 0x3c14086a, 0x0d006599, 0x443c18be, 0x9f789fd7, 0xd644e2f0,
+        0x2c1de7f4, 0x65219ad3, 0xbe651dba, 0xf759609d, 0x4f3b6143, 0x06071c64,
+        0xdd439b0d, 0x947fe62a, 0x6e26e32e, 0x271a9e09, 0xfc5e1960, 0xb5626447,
+        0x89766c2d, 0xc04a110a, 0x1b0e9663, 0x5232eb44, 0xa86bee40, 0xe1579367,
+        0x3a13140e, 0x732f6929, 0xcb4d68f7, 0x827115d0, 0x593592b9, 0x1009ef9e,
+        0xea50ea9a, 0xa36c97bd, 0x782810d4, 0x31146df3, 0x1a00cb32, 0x533cb615,
+        0x8878317c, 0xc1444c5b, 0x3b1d495f, 0x72213478, 0xa965b311, 0xe059ce36,
+        0x583bcfe8, 0x1107b2cf, 0xca4335a6, 0x837f4881, 0x79264d85, 0x301a30a2,
+        0xeb5eb7cb, 0xa262caec, 0x9e76c286, 0xd74abfa1, 0x0c0e38c8, 0x453245ef,
+        0xbf6b40eb, 0xf6573dcc, 0x2d13baa5, 0x642fc782, 0xdc4dc65c, 0x9571bb7b,
+        0x4e353c12, 0x07094135, 0xfd504431, 0xb46c3916, 0x6f28be7f, 0x2614c358,
+        0x1700aeab, 0x5e3cd38c, 0x857854e5, 0xcc4429c2, 0x361d2cc6, 0x7f2151e1,
+        0xa465d688, 0xed59abaf, 0x553baa71, 0x1c07d756, 0xc743503f, 0x8e7f2d18,
+        0x7426281c, 0x3d1a553b, 0xe65ed252, 0xaf62af75, 0x9376a71f, 0xda4ada38,
+        0x010e5d51, 0x48322076, 0xb26b2572, 0xfb575855, 0x2013df3c, 0x692fa21b,
+        0xd14da3c5, 0x9871dee2, 0x4335598b, 0x0a0924ac, 0xf05021a8, 0xb96c5c8f,
+        0x6228dbe6, 0x2b14a6c1, 0x34019664, 0x7d3deb43, 0xa6796c2a, 0xef45110d,
+        0x151c1409, 0x5c20692e, 0x8764ee47, 0xce589360, 0x763a92be, 0x3f06ef99,
+        0xe44268f0, 0xad7e15d7, 0x572710d3, 0x1e1b6df4, 0xc55fea9d, 0x8c6397ba,
+        0xb0779fd0, 0xf94be2f7, 0x220f659e, 0x6b3318b9, 0x916a1dbd, 0xd856609a,
+        0x0312e7f3, 0x4a2e9ad4, 0xf24c9b0a, 0xbb70e62d, 0x60346144, 0x29081c63,
+        0xd3511967, 0x9a6d6440, 0x4129e329, 0x08159e0e, 0x3901f3fd, 0x703d8eda,
+        0xab7909b3, 0xe2457494, 0x181c7190, 0x51200cb7, 0x8a648bde, 0xc358f6f9,
+        0x7b3af727, 0x32068a00, 0xe9420d69, 0xa07e704e, 0x5a27754a, 0x131b086d,
+        0xc85f8f04, 0x8163f223, 0xbd77fa49, 0xf44b876e, 0x2f0f0007, 0x66337d20,
+        0x9c6a7824, 0xd5560503, 0x0e12826a, 0x472eff4d, 0xff4cfe93, 0xb67083b4,
+        0x6d3404dd, 0x240879fa, 0xde517cfe, 0x976d01d9, 0x4c2986b0, 0x0515fb97,
+        0x2e015d56, 0x673d2071, 0xbc79a718, 0xf545da3f, 0x0f1cdf3b, 0x4620a21c,
+        0x9d642575, 0xd4585852, 0x6c3a598c, 0x250624ab, 0xfe42a3c2, 0xb77edee5,
+        0x4d27dbe1, 0x041ba6c6, 0xdf5f21af, 0x96635c88, 0xaa7754e2, 0xe34b29c5,
+        0x380faeac, 0x7133d38b, 0x8b6ad68f, 0xc256aba8, 0x19122cc1, 0x502e51e6,
+        0xe84c5038, 0xa1702d1f, 0x7a34aa76, 0x3308d751, 0xc951d255, 0x806daf72,
+        0x5b29281b, 0x1215553c, 0x230138cf, 0x6a3d45e8, 0xb179c281, 0xf845bfa6,
+        0x021cbaa2, 0x4b20c785, 0x906440ec, 0xd9583dcb, 0x613a3c15, 0x28064132,
+        0xf342c65b, 0xba7ebb7c, 0x4027be78, 0x091bc35f, 0xd25f4436, 0x9b633911,
+        0xa777317b, 0xee4b4c5c, 0x350fcb35, 0x7c33b612, 0x866ab316, 0xcf56ce31,
+        0x14124958, 0x5d2e347f, 0xe54c35a1, 0xac704886, 0x7734cfef, 0x3e08b2c8,
+        0xc451b7cc, 0x8d6dcaeb, 0x56294d82, 0x1f1530a5
+    }};
+
+/*
+ * Copies count bytes from source to destination while extending crc, a
+ * CRC32C of the bytes before them (0 to start), over them, in a single pass.
+ * With SSE4.2 or the Arm CRC extension this uses the crc32c instructions, 8
+ * bytes at a time; otherwise slicing-by-8 tables.
+ */
+static inline uint32_t safec_memcpy_crc32c(
+    unsigned char* destination,
+    const unsigned char* source,
+    size_t count,
+    uint32_t crc) {
+  crc = ~crc;
+  size_t i = 0;
+  for (; count - i >= 8; i += 8) {
+    uint64_t block;
+    memcpy(&block, source + i, 8);
+    memcpy(destination + i, &block, 8);
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    crc = (uint32_t)_mm_crc32_u64(crc, block);
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    crc = __crc32cd(crc, block);
+#else
+    const unsigned char* const in = source + i;
+    const uint32_t low = crc ^
+        ((uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 |
+         (uint32_t)in[3] << 24);
+    crc = safec_crc32c_table[7][low & 0xff] ^
+        safec_crc32c_table[6][(low >> 8) & 0xff] ^
+        safec_crc32c_table[5][(low >> 16) & 0xff] ^
+        safec_crc32c_table[4][low >> 24] ^ safec_crc32c_table[3][in[4]] ^
+        safec_crc32c_table[2][in[5]] ^ safec_crc32c_table[1][in[6]] ^
+        safec_crc32c_table[0][in[7]];
+#endif
+  }
+  for (; i < count; ++i) {
+    const unsigned char byte = source[i];
+    destination[i] = byte;
+    crc = (crc >> 8) ^ safec_crc32c_table[0][(crc ^ byte) & 0xff];
+  }
+  return ~crc;
+}
+
+/**
+ * Bounds checking wrapper for std::memcpy that also computes the CRC32C
+ * (Castagnoli) checksum of the copied bytes in the same pass. This version
+ * aborts the process if there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @param crc
+ *      On input the CRC32C of any preceding data (0 to start a new checksum),
+ * on output the CRC32C extended over the copied bytes.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memcpy_crc32c(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t count,
+    uint32_t* crc) {
+  SAFEC_OP(checked_memcpy_crc32c, destination, source, count, destination_size);
+  if (destination_size < count) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (source == BAD_PTR || destination == BAD_PTR || crc == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  *crc = SAFEC_OP_CALL(safec_memcpy_crc32c(
+      (unsigned char*)destination, (const unsigned char*)source, count, *crc));
+  return destination;
+}
+
+/**
+ * Bounds checking wrapper for std::memcpy that also computes the CRC32C
+ * checksum of the copied bytes. This version returns an error code instead of
+ * aborting. Error handling is mandatory.
+ *
+ * @return int
+ *      Returns zero on success and ERR_POTENTIAL_BUFFER_OVERFLOW if count
+ * exceeds destination_size, in which case *crc is left untouched.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy_crc32c(
+    void* destination,
+    size_t destination_size,
+    const void* source,
+    size_t count,
+    uint32_t* crc) {
+  SAFEC_OP(
+      try_checked_memcpy_crc32c, destination, source, count, destination_size);
+  if (destination_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *crc = SAFEC_OP_CALL(safec_memcpy_crc32c(
+      (unsigned char*)destination, (const unsigned char*)source, count, *crc));
+  return 0;
+}
+
+// Sets *extent to the bytes spanned by rows rows of row_bytes bytes, pitch
+// bytes apart: (rows - 1) * pitch + row_bytes, or 0 without rows.
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+safec_2d_extent(size_t rows, size_t pitch, size_t row_bytes, size_t* extent) {
+  if (rows == 0) {
+    *extent = 0;
+    return 0;
+  }
+  size_t offset;
+  if (try_checked_mul_size(rows - 1, pitch, &offset) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  return try_checked_add_size(offset, row_bytes, extent);
+}
+
+/*
+ * Copies rows rows of row_bytes bytes. Rows that are contiguous on both sides
+ * are copied with a single memcpy; otherwise two rows are copied per
+ * iteration while the source rows after them are prefetched. Returns
+ * destination.
+ */
+static inline void* safec_memcpy_2d(
+    unsigned char* destination,
+    size_t destination_pitch,
+    const unsigned char* source,
+    size_t source_pitch,
+    size_t row_bytes,
+    size_t rows) {
+  if (row_bytes == destination_pitch && row_bytes == source_pitch) {
+    return memcpy(destination, source, row_bytes * rows);
+  }
+  unsigned char* const start = destination;
+  size_t row = 0;
+  for (; rows - row >= 2; row += 2) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (rows - row >= 4) {
+      __builtin_prefetch(source + 2 * source_pitch);
+      __builtin_prefetch(source + 3 * source_pitch);
+    }
+#endif
+    memcpy(destination, source, row_bytes);
+    memcpy(destination + destination_pitch, source + source_pitch, row_bytes);
+    destination += 2 * destination_pitch;
+    source += 2 * source_pitch;
+  }
+  if (row < rows) {
+    memcpy(destination, source, row_bytes);
+  }
+  return start;
+}
+
+/**
+ * Bounds checking wrapper for copying a 2D block, e.g. an image tile or a
+ * matrix sub-block, row by row. Both extents, (rows - 1) * pitch + row_bytes,
+ * are computed with overflow checks and validated once for the whole block.
+ * This version aborts the process if there's a possibility of buffer
+ * overflow, or if row_bytes exceeds destination_pitch so that destination
+ * rows would overlap.
+ *
+ * @param destination
+ *      Pointer to the first destination row.
+ * @param destination_size
+ *      Number of bytes that may be written from destination onwards.
+ * @param destination_pitch
+ *      Distance in bytes between the starts of consecutive destination rows.
+ * @param source
+ *      Pointer to the first source row.
+ * @param source_size
+ *      Number of bytes that may be read from source onwards.
+ * @param source_pitch
+ *      Distance in bytes between the starts of consecutive source rows.
+ * @param row_bytes
+ *      Number of bytes to copy from each row.
+ * @param rows
+ *      Number of rows to copy.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memcpy_2d(
+    void* destination,
+    size_t destination_size,
+    size_t destination_pitch,
+    const void* source,
+    size_t source_size,
+    size_t source_pitch,
+    size_t row_bytes,
+    size_t rows) {
+  size_t destination_extent;
+  size_t source_extent;
+  const int destination_error = safec_2d_extent(
+      rows, destination_pitch, row_bytes, &destination_extent);
+  const int source_error =
+      safec_2d_extent(rows, source_pitch, row_bytes, &source_extent);
+  SAFEC_OP(
+      checked_memcpy_2d,
+      destination,
+      source,
+      destination_error ? SIZE_MAX : destination_extent,
+      destination_size);
+  if (destination_error != 0 || source_error != 0) {
+    integer_overflow_error(__func__);
+  }
+  if (rows > 1 && row_bytes > destination_pitch) {
+    invalid_argument_error(__func__);
+  }
+  if (destination_size < destination_extent) {
+    buffer_overflow_error_with_size(
+        __func__, destination_size, destination_extent);
+  }
+  if (source_size < source_extent) {
+    buffer_oob_read_error(__func__);
+  }
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  SAFEC_OP_CALL(safec_memcpy_2d(
+      (unsigned char*)destination,
+      destination_pitch,
+      (const unsigned char*)source,
+      source_pitch,
+      row_bytes,
+      rows));
+  return destination;
+}
+
+/**
+ * Bounds checking wrapper for copying a 2D block row by row. This version
+ * returns an error code instead of aborting. Error handling is mandatory.
+ *
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_INTEGER_OVERFLOW if an extent
+ * does not fit in size_t, ERR_INVALID_ARGUMENT if destination rows would
+ * overlap and ERR_POTENTIAL_BUFFER_OVERFLOW if an extent exceeds its size.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcpy_2d(
+    void* destination,
+    size_t destination_size,
+    size_t destination_pitch,
+    const void* source,
+    size_t source_size,
+    size_t source_pitch,
+    size_t row_bytes,
+    size_t rows) {
+  size_t destination_extent;
+  size_t source_extent;
+  const int destination_error = safec_2d_extent(
+      rows, destination_pitch, row_bytes, &destination_extent);
+  const int source_error =
+      safec_2d_extent(rows, source_pitch, row_bytes, &source_extent);
+  SAFEC_OP(
+      try_checked_memcpy_2d,
+      destination,
+      source,
+      destination_error ? SIZE_MAX : destination_extent,
+      destination_size);
+  if (destination_error != 0 || source_error != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  if (rows > 1 && row_bytes > destination_pitch) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  if (destination_size < destination_extent || source_size < source_extent) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  SAFEC_OP_CALL(safec_memcpy_2d(
+      (unsigned char*)destination,
+      destination_pitch,
+      (const unsigned char*)source,
+      source_pitch,
+      row_bytes,
+      rows));
+  return 0;
+}
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::strcat. This version
+ * aborts the process if there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be concatenated.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be concatenated into destination.
+ * @return char *
+ *      Pointer to the destination.
+ */
+
+SAFEC_API char*
+checked_strcat(char* destination, size_t destination_size, const char* source) {
+  const size_t dest_str_len = strlen(destination);
+  const size_t src_str_len = strlen(source);
+  const size_t tot_str_len = dest_str_len + src_str_len;
+  SAFEC_OP(
+      checked_strcat,
+      destination + dest_str_len,
+      source,
+      tot_str_len + 1,
+      destination_size);
+
+  if (destination_size == 0) {
+    buffer_overflow_error_with_size(__func__, destination_size, tot_str_len);
+  }
+
+  if (dest_str_len + src_str_len < dest_str_len) {
+    integer_overflow_error(__func__);
+  }
+
+  if (destination_size - 1 < tot_str_len) {
+    buffer_overflow_error_with_size(
+        __func__, destination_size - 1, tot_str_len);
+  }
+  // We already know lengths, use memcpy
+  SAFEC_OP_CALL(memcpy(destination + dest_str_len, source, src_str_len));
+  *(destination + dest_str_len + src_str_len) = '\0';
+  return destination;
+}
+
+/**
+ * Bounds checking (i.e. destination) wrapper for std::strcat. This version adds
+ * bounds checking capability and returns an error code if there's any potential
+ * buffer overflow detected. Error handling is mandatory. Note that using this
+ * function without error handling does not guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be concatenated.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be concatenated into destination.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_strcat(
+    char* destination,
+    size_t destination_size,
+    const char* source) {
+  if (destination_size == 0) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  const size_t dest_str_len = strlen(destination);
+  const size_t src_str_len = strlen(source);
+  SAFEC_OP(
+      try_checked_strcat,
+      destination + dest_str_len,
+      source,
+      dest_str_len + src_str_len + 1,
+      destination_size);
+  if (dest_str_len + src_str_len < dest_str_len) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+
+  if (destination_size - 1 < dest_str_len + src_str_len) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  SAFEC_OP_CALL(memcpy(destination + dest_str_len, source, src_str_len));
+  *(destination + dest_str_len + src_str_len) = '\0';
+  return 0;
+}
+
+/**
+ * Truncating wrapper for std::strcat: appends as much of source as fits and
+ * always leaves destination NUL-terminated (unless destination_size is 0).
+ * Neither string is read past what could be written: the destination is
+ * scanned within destination_size and the source within the space left. This
+ * version aborts the process on null pointers.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be concatenated.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be concatenated into destination.
+ * @param truncated
+ *      If not NULL, receives 1 if source was not appended entirely and 0
+ * otherwise.
+ * @return size_t
+ *      Number of characters appended, not counting the terminating NUL.
+ */
+SAFEC_API size_t checked_strcat_clamp(
+    char* destination,
+    size_t destination_size,
+    const char* source,
+    int* truncated) {
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  if (destination_size == 0) {
+    if (truncated != BAD_PTR) {
+      *truncated = *source != '\0';
+    }
+    return 0;
+  }
+
+  // An unterminated destination is cut to its last byte.
+  const char* dest_end =
+      (const char*)memchr(destination, '\0', destination_size);
+  const size_t dest_str_len = dest_end != BAD_PTR
+      ? (size_t)(dest_end - destination)
+      : destination_size - 1;
+  const size_t available = destination_size - 1 - dest_str_len;
+  const char* src_end = (const char*)memchr(source, '\0', available + 1);
+  const size_t src_str_len =
+      src_end != BAD_PTR ? (size_t)(src_end - source) : available + 1;
+  SAFEC_OP(
+      checked_strcat_clamp,
+      destination + dest_str_len,
+      source,
+      dest_str_len + src_str_len + 1,
+      destination_size);
+
+  const size_t copied = src_str_len < available ? src_str_len : available;
+  if (truncated != BAD_PTR) {
+    *truncated = src_str_len > available;
+  }
+  SAFEC_OP_CALL(memcpy(destination + dest_str_len, source, copied));
+  destination[dest_str_len + copied] = '\0';
+  return copied;
+}
+
+/**
+ * Bounds checking (i.e. src, dest) wrapper for std::memcmp. This version
+ * aborts the process if there's a possibility of reading out-of-bounds.
+ *
+ * @param ptr1
+ *      Pointer to block of memory
+ * @param ptr1_size
+ *      Max number of bytes that can be read from ptr1 (typically the allocated
+ * size of the buffer)
+ * @param ptr2
+ *      Pointer to block of memory
+ * @param ptr2_size
+ *      Max number of bytes that can be read from ptr2 (typically the allocated
+ * size of the buffer)
+ * @param num
+ *      Number of bytes to compare
+ * @return int
+ *      Returns an integral value indicating the relationship between the
+ * content of the memory blocks.
+ *
+ * return value < 0: the first byte that does not match in both memory blocks
+ * has a lower value in ptr1 than in ptr2 (if evaluated as unsigned char values)
+ *
+ * return value == 0: the contents of both memory blocks are equal
+ *
+ * return value > 0: the first byte that does not match in both memory blocks
+ * has a greater value in ptr1 than in ptr2 (if evaluated as unsigned char
+ * values)
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int checked_memcmp(
+    const void* ptr1,
+    size_t ptr1_size,
+    const void* ptr2,
+    size_t ptr2_size,
+    size_t num) {
+  SAFEC_OP(
+      checked_memcmp,
+      ptr1,
+      ptr2,
+      num,
+      ptr1_size < ptr2_size ? ptr1_size : ptr2_size);
+  if (num > ptr1_size || num > ptr2_size) {
+    buffer_oob_read_error(__func__);
+  }
+
+  return SAFEC_OP_CALL(memcmp(ptr1, ptr2, num));
+}
+
+/**
+ * Bounds checking (i.e. src, dest) wrapper for std::memcmp. This version
+ * returns an error code if there's a possibility of reading out-of-bounds.
+ * Error handling is mandatory.
+ *
+ * @param ptr1
+ *      Pointer to block of memory
+ * @param ptr1_size
+ *      Max number of bytes that can be read from ptr1 (typically the allocated
+ * size of the buffer)
+ * @param ptr2
+ *      Pointer to block of memory
+ * @param ptr2_size
+ *      Max number of bytes that can be read from ptr2 (typically the allocated
+ * size of the buffer)
+ * @param num
+ *      Number of bytes to compare
+ * @param result
+ *      Receives the memcmp result on success (see checked_memcmp).
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memcmp(
+    const void* ptr1,
+    size_t ptr1_size,
+    const void* ptr2,
+    size_t ptr2_size,
+    size_t num,
+    int* result) {
+  SAFEC_OP(
+      try_checked_memcmp,
+      ptr1,
+      ptr2,
+      num,
+      ptr1_size < ptr2_size ? ptr1_size : ptr2_size);
+  if (num > ptr1_size || num > ptr2_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  *result = SAFEC_OP_CALL(memcmp(ptr1, ptr2, num));
+  return 0;
+}
+
+/**
+ * Bounds checking (for both strings) wrapper for std::strncmp.
+ * This version aborts the process if there's a possibility of buffer over-read.
+ *
+ * @param str1
+ *      First string to be compared.
+ * @param str1_size
+ *      Max number of bytes of the first string (typically the size of the first
+ * string).
+ * @param str2
+ *      Second string to be compared.
+ * @param str2_size
+ *      Max number of bytes of the second string (typically the size of the
+ second
+ * string).
+ * @param count
+ *      Number of bytes to compare.
+ * @return int
+ *      1) < 0: the first character that does not match has a lower value in
+ str1 than in str2;
+ *      2) 0: the contents of both strings are equal;
+ *      3) > 0: the first character that does not match has a greater value in
+ str1 than in str2.
+ */
+SAFEC_API int checked_strncmp(
+    const char* str1,
+    size_t str1_size,
+    const char* str2,
+    size_t str2_size,
+    size_t count) {
+  SAFEC_OP(
+      checked_strncmp,
+      str1,
+      str2,
+      count,
+      str1_size < str2_size ? str1_size : str2_size);
+  if (str1_size < count || str2_size < count) {
+    buffer_oob_read_error(__func__);
+  }
+
+  return SAFEC_OP_CALL(strncmp(str1, str2, count));
+}
+
+/**
+ * Bounds checking (for both strings) wrapper for std::strncmp. This version
+ * returns an error code if there's a possibility of buffer over-read. Error
+ * handling is mandatory.
+ *
+ * @param str1
+ *      First string to be compared.
+ * @param str1_size
+ *      Max number of bytes of the first string (typically the size of the first
+ * string).
+ * @param str2
+ *      Second string to be compared.
+ * @param str2_size
+ *      Max number of bytes of the second string (typically the size of the
+ * second string).
+ * @param count
+ *      Number of bytes to compare.
+ * @param result
+ *      Receives the strncmp result on success (see checked_strncmp).
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_strncmp(
+    const char* str1,
+    size_t str1_size,
+    const char* str2,
+    size_t str2_size,
+    size_t count,
+    int* result) {
+  SAFEC_OP(
+      try_checked_strncmp,
+      str1,
+      str2,
+      count,
+      str1_size < str2_size ? str1_size : str2_size);
+  if (str1_size < count || str2_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  *result = SAFEC_OP_CALL(strncmp(str1, str2, count));
+  return 0;
+}
+
+/**
+ * Bounds checking wrapper for std::memset. This version aborts the process if
+ * there's a possibility of writing out-of-bounds.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be stored.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param ch
+ *      Byte to fill into the destination.
+ * @param count
+ *      Number of bytes to store.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memset(
+    void* destination,
+    size_t destination_size,
+    int ch,
+    size_t count) {
+  SAFEC_OP(checked_memset, destination, BAD_PTR, count, destination_size);
+  if (count > destination_size) {
+    buffer_overflow_error(__func__);
+  }
+
+  return SAFEC_OP_CALL(memset(destination, ch, count));
+}
+
+/**
+ * Bounds checking wrapper for std::memset. This version returns an error code
+ * if there's a possibility of writing out-of-bounds. Error handling is
+ * mandatory. Note that using this function without error handling does not
+ * guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be stored.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param ch
+ *      Byte to fill into the destination.
+ * @param count
+ *      Number of bytes to store.
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memset(
+    void* destination,
+    size_t destination_size,
+    int ch,
+    size_t count) {
+  SAFEC_OP(try_checked_memset, destination, BAD_PTR, count, destination_size);
+  if (count > destination_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  SAFEC_OP_CALL(memset(destination, ch, count));
+  return 0;
+}
+
+// Fills at least this many bytes use non-temporal stores on x86, which bypass
+// the cache: a fill this large would evict the working set for data that is
+// unlikely to be read back before it is evicted again.
+#ifndef SAFEC_MEMSET_STREAM_THRESHOLD
+#define SAFEC_MEMSET_STREAM_THRESHOLD ((size_t)8 << 20)
+#endif
+
+/*
+ * Fills count bytes at destination from block, 64 bytes repeating a pattern
+ * whose length divides 16, starting at phase 0. Because every 16-byte step
+ * keeps the phase, the fixed-size copies from block compile to broadcast
+ * vector stores, and block + (offset % 16) is the pattern rotated to offset.
+ * Returns destination.
+ */
+static inline void* safec_memset_block(
+    unsigned char* destination,
+    size_t count,
+    const unsigned char* block) {
+  size_t i = 0;
+  if (count < 16) {
+    memcpy(destination, block, count);
+    return destination;
+  }
+#if defined(__SSE2__)
+  if (count >= SAFEC_MEMSET_STREAM_THRESHOLD) {
+    // Unaligned head up to the first 16-byte boundary, then streaming stores.
+    memcpy(destination, block, 16);
+    i = 16 - (uintptr_t)destination % 16;
+    const __m128i value = _mm_loadu_si128((const __m128i*)(block + i % 16));
+    for (; count - i >= 16; i += 16) {
+      _mm_stream_si128((__m128i*)(destination + i), value);
+    }
+    _mm_sfence();
+  }
+#endif
+  for (; count - i >= 32; i += 32) {
+    memcpy(destination + i, block + i % 16, 32);
+  }
+  if (count - i >= 16) {
+    memcpy(destination + i, block + i % 16, 16);
+  }
+  // The last 16 bytes, overlapping what was already stored.
+  memcpy(destination + count - 16, block + (count - 16) % 16, 16);
+  return destination;
+}
+
+/*
+ * Fills count bytes at destination with copies of the pattern_len-byte
+ * pattern; the last copy may be partial. Patterns whose length divides 16 go
+ * through safec_memset_block. Other patterns are stored once and then doubled
+ * by copying the filled prefix after itself, in steps of at most 4 KiB once
+ * the prefix is that large so the source of each copy stays in L1. Returns
+ * destination.
+ */
+static inline void* safec_memset_pattern(
+    unsigned char* destination,
+    size_t count,
+    const unsigned char* pattern,
+    size_t pattern_len) {
+  if (16 % pattern_len == 0) {
+    unsigned char block[64];
+    for (size_t i = 0; i < sizeof(block); i += pattern_len) {
+      memcpy(block + i, pattern, pattern_len);
+    }
+    return safec_memset_block(destination, count, block);
+  }
+  size_t filled = pattern_len < count ? pattern_len : count;
+  memcpy(destination, pattern, filled);
+  // step stays a multiple of pattern_len so every copy starts at phase 0.
+  size_t step = filled;
+  while (filled < count) {
+    const size_t chunk = step < count - filled ? step : count - filled;
+    memcpy(destination + filled, destination, chunk);
+    filled += chunk;
+    if (step < 4096) {
+      step = filled;
+    }
+  }
+  return destination;
+}
+
+/*
+ * Wide fills.
+ *
+ * checked_memset16/32/64 fill count elements of 16, 32 or 64 bits with value,
+ * for sentinels checked_memset cannot express (0xFFFF ids, float NaNs, 64-bit
+ * tombstones). destination_size is in bytes, and count * element size is
+ * overflow-checked before it is compared against it. The value is stored in
+ * host byte order, as an assignment to each element would store it. Fills
+ * use vector stores, and non-temporal stores on x86 once they reach
+ * SAFEC_MEMSET_STREAM_THRESHOLD bytes. destination need not be aligned. The
+ * aborting versions abort the process and the try_ versions return
+ * ERR_POTENTIAL_BUFFER_OVERFLOW or ERR_POTENTIAL_INTEGER_OVERFLOW.
+ */
+#define SAFEC_DEFINE_MEMSET_WIDE(bits)                                    \
+  SAFEC_API void* checked_memset##bits(                                   \
+      void* destination,                                                  \
+      size_t destination_size,                                            \
+      uint##bits##_t value,                                               \
+      size_t count) {                                                     \
+    SAFEC_OP(                                                             \
+        checked_memset##bits,                                             \
+        destination,                                                      \
+        BAD_PTR,                                                          \
+        count * ((bits) / 8),                                             \
+        destination_size);                                                \
+    size_t bytes;                                                         \
+    if (try_checked_mul_size(count, (bits) / 8, &bytes) != 0) {           \
+      integer_overflow_error(__func__);                                   \
+    }                                                                     \
+    if (destination_size < bytes) {                                       \
+      buffer_overflow_error_with_size(__func__, destination_size, bytes); \
+    }                                                                     \
+    if (destination == BAD_PTR) {                                         \
+      null_pointer_error(__func__);                                       \
+    }                                                                     \
+    SAFEC_OP_CALL(safec_memset_pattern(                                   \
+        (unsigned char*)destination,                                      \
+        bytes,                                                            \
+        (const unsigned char*)&value,                                     \
+        (bits) / 8));                                                     \
+    return destination;                                                   \
+  }                                                                       \
+  SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memset##bits(   \
+      void* destination,                                                  \
+      size_t destination_size,                                            \
+      uint##bits##_t value,                                               \
+      size_t count) {                                                     \
+    SAFEC_OP(                                                             \
+        try_checked_memset##bits,                                         \
+        destination,                                                      \
+        BAD_PTR,                                                          \
+        count * ((bits) / 8),                                             \
+        destination_size);                                                \
+    size_t bytes;                                                         \
+    if (try_checked_mul_size(count, (bits) / 8, &bytes) != 0) {           \
+      return ERR_POTENTIAL_INTEGER_OVERFLOW;                              \
+    }                                                                     \
+    if (destination_size < bytes) {                                       \
+      return ERR_POTENTIAL_BUFFER_OVERFLOW;                               \
+    }                                                                     \
+    SAFEC_OP_CALL(safec_memset_pattern(                                   \
+        (unsigned char*)destination,                                      \
+        bytes,                                                            \
+        (const unsigned char*)&value,                                     \
+        (bits) / 8));                                                     \
+    return 0;                                                             \
+  }
+
+SAFEC_DEFINE_MEMSET_WIDE(16)
+SAFEC_DEFINE_MEMSET_WIDE(32)
+SAFEC_DEFINE_MEMSET_WIDE(64)
+
+#undef SAFEC_DEFINE_MEMSET_WIDE
+
+/**
+ * Fills the destination with repeated copies of a pattern. This version aborts
+ * the process if there's a possibility of writing out-of-bounds, or if the
+ * pattern is empty.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be stored.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param pattern
+ *      Pointer to the pattern to repeat. Must not overlap the destination.
+ * @param pattern_len
+ *      Number of bytes in the pattern.
+ * @param count
+ *      Number of bytes to store. The last copy of the pattern is truncated
+ * if count is not a multiple of pattern_len.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memset_pattern(
+    void* destination,
+    size_t destination_size,
+    const void* pattern,
+    size_t pattern_len,
+    size_t count) {
+  SAFEC_OP(
+      checked_memset_pattern, destination, pattern, count, destination_size);
+  if (count > destination_size) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (pattern_len == 0 && count != 0) {
+    invalid_argument_error(__func__);
+  }
+  if (pattern == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  if (count == 0) {
+    return destination;
+  }
+
+  return SAFEC_OP_CALL(safec_memset_pattern(
+      (unsigned char*)destination,
+      count,
+      (const unsigned char*)pattern,
+      pattern_len));
+}
+
+/**
+ * Fills the destination with repeated copies of a pattern. This version
+ * returns an error code if there's a possibility of writing out-of-bounds, or
+ * if the pattern is empty. Error handling is mandatory. Note that using this
+ * function without error handling does not guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be stored.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param pattern
+ *      Pointer to the pattern to repeat. Must not overlap the destination.
+ * @param pattern_len
+ *      Number of bytes in the pattern.
+ * @param count
+ *      Number of bytes to store. The last copy of the pattern is truncated
+ * if count is not a multiple of pattern_len.
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memset_pattern(
+    void* destination,
+    size_t destination_size,
+    const void* pattern,
+    size_t pattern_len,
+    size_t count) {
+  SAFEC_OP(
+      try_checked_memset_pattern,
+      destination,
+      pattern,
+      count,
+      destination_size);
+  if (count > destination_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  if (pattern_len == 0 && count != 0) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  SAFEC_OP_CALL(safec_memset_pattern(
+      (unsigned char*)destination,
+      count,
+      (const unsigned char*)pattern,
+      pattern_len));
+  return 0;
+}
+
+/*
+ * Bounded spans.
+ *
+ * sc_span and sc_cspan pair a pointer with the number of bytes that may be
+ * accessed through it. They are two words wide and passed by value, so the
+ * bounds travel in registers. Slicing is overflow-safe: the aborting
+ * functions abort on an out-of-range request and the try_ functions return
+ * ERR_POTENTIAL_BUFFER_OVERFLOW and leave their outputs untouched.
+ */
+typedef struct sc_span {
+  unsigned char* ptr;
+  size_t len;
+} sc_span;
+
+typedef struct sc_cspan {
+  const unsigned char* ptr;
+  size_t len;
+} sc_cspan;
+
+static inline sc_span sc_span_make(void* ptr, size_t len) {
+  sc_span span = {(unsigned char*)ptr, len};
+  return span;
+}
+
+static inline sc_cspan sc_cspan_make(const void* ptr, size_t len) {
+  sc_cspan span = {(const unsigned char*)ptr, len};
+  return span;
+}
+
+static inline sc_cspan sc_span_as_const(sc_span span) {
+  return sc_cspan_make(span.ptr, span.len);
+}
+
+// Same reasoning as checked_memcpy_offset: never compute len - offset when
+// offset is out of range.
+static inline int sc_span_range_fits(size_t len, size_t offset, size_t count) {
+  return offset <= len && count <= len - offset;
+}
+
+/**
+ * Returns the count bytes of span starting at offset. Aborts the process if
+ * the range is not within span.
+ */
+static inline sc_span
+sc_span_subspan(sc_span span, size_t offset, size_t count) {
+  if (!sc_span_range_fits(span.len, offset, count)) {
+    buffer_overflow_error_with_size(
+        __func__, offset > span.len ? 0 : span.len - offset, count);
+  }
+  return sc_span_make(span.ptr + offset, count);
+}
+
+static inline sc_cspan
+sc_cspan_subspan(sc_cspan span, size_t offset, size_t count) {
+  if (!sc_span_range_fits(span.len, offset, count)) {
+    buffer_oob_read_error(__func__);
+  }
+  return sc_cspan_make(span.ptr + offset, count);
+}
+
+/**
+ * Returns the count bytes of span starting at offset in out, or an error code
+ * if the range is not within span.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_span_subspan(sc_span span, size_t offset, size_t count, sc_span* out) {
+  if (!sc_span_range_fits(span.len, offset, count)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_span_make(span.ptr + offset, count);
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_cspan_subspan(
+    sc_cspan span,
+    size_t offset,
+    size_t count,
+    sc_cspan* out) {
+  if (!sc_span_range_fits(span.len, offset, count)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_cspan_make(span.ptr + offset, count);
+  return 0;
+}
+
+/**
+ * Drops the first count bytes of *span. Aborts the process if span is
+ * shorter than count.
+ */
+static inline void sc_span_advance(sc_span* span, size_t count) {
+  if (count > span->len) {
+    buffer_overflow_error_with_size(__func__, span->len, count);
+  }
+  span->ptr += count;
+  span->len -= count;
+}
+
+static inline void sc_cspan_advance(sc_cspan* span, size_t count) {
+  if (count > span->len) {
+    buffer_oob_read_error(__func__);
+  }
+  span->ptr += count;
+  span->len -= count;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_span_advance(
+    sc_span* span,
+    size_t count) {
+  if (count > span->len) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  span->ptr += count;
+  span->len -= count;
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_cspan_advance(
+    sc_cspan* span,
+    size_t count) {
+  if (count > span->len) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  span->ptr += count;
+  span->len -= count;
+  return 0;
+}
+
+/**
+ * Splits span into its first at bytes (head) and the rest (tail). Aborts the
+ * process if span is shorter than at.
+ */
+static inline void
+sc_span_split(sc_span span, size_t at, sc_span* head, sc_span* tail) {
+  if (at > span.len) {
+    buffer_overflow_error_with_size(__func__, span.len, at);
+  }
+  *head = sc_span_make(span.ptr, at);
+  *tail = sc_span_make(span.ptr + at, span.len - at);
+}
+
+static inline void
+sc_cspan_split(sc_cspan span, size_t at, sc_cspan* head, sc_cspan* tail) {
+  if (at > span.len) {
+    buffer_oob_read_error(__func__);
+  }
+  *head = sc_cspan_make(span.ptr, at);
+  *tail = sc_cspan_make(span.ptr + at, span.len - at);
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_span_split(sc_span span, size_t at, sc_span* head, sc_span* tail) {
+  if (at > span.len) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *head = sc_span_make(span.ptr, at);
+  *tail = sc_span_make(span.ptr + at, span.len - at);
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cspan_split(sc_cspan span, size_t at, sc_cspan* head, sc_cspan* tail) {
+  if (at > span.len) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *head = sc_cspan_make(span.ptr, at);
+  *tail = sc_cspan_make(span.ptr + at, span.len - at);
+  return 0;
+}
+
+/**
+ * Copies all of source to the start of destination (see checked_memcpy).
+ *
+ * @return size_t
+ *      Number of bytes copied, i.e. source.len.
+ */
+static inline size_t sc_span_copy(sc_span destination, sc_cspan source) {
+  // Empty spans may be {NULL, 0}, which checked_memcpy rejects.
+  if (source.len == 0) {
+    return 0;
+  }
+  checked_memcpy(destination.ptr, destination.len, source.ptr, source.len);
+  return source.len;
+}
+
+/**
+ * Copies all of source to the start of destination (see try_checked_memcpy).
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_span_copy(
+    sc_span destination,
+    sc_cspan source) {
+  if (source.len == 0) {
+    return 0;
+  }
+  return try_checked_memcpy(
+      destination.ptr, destination.len, source.ptr, source.len);
+}
+
+/**
+ * Compares the first num bytes of two spans (see checked_memcmp).
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+sc_span_compare(sc_cspan ptr1, sc_cspan ptr2, size_t num) {
+  return checked_memcmp(ptr1.ptr, ptr1.len, ptr2.ptr, ptr2.len, num);
+}
+
+/**
+ * Compares the first num bytes of two spans (see try_checked_memcmp).
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_span_compare(sc_cspan ptr1, sc_cspan ptr2, size_t num, int* result) {
+  return try_checked_memcmp(
+      ptr1.ptr, ptr1.len, ptr2.ptr, ptr2.len, num, result);
+}
+
+/**
+ * Returns 1 if both spans have the same length and contents, 0 otherwise.
+ */
+static inline int sc_span_equal(sc_cspan ptr1, sc_cspan ptr2) {
+  return ptr1.len == ptr2.len &&
+      checked_memcmp(ptr1.ptr, ptr1.len, ptr2.ptr, ptr2.len, ptr1.len) == 0;
+}
+
+/**
+ * Fills the whole of destination with ch.
+ */
+static inline void sc_span_set(sc_span destination, int ch) {
+  checked_memset(destination.ptr, destination.len, ch, destination.len);
+}
+
+/*
+ * Bounded cursors.
+ *
+ * sc_cursor keeps a buffer's start, a current position and its end, so code
+ * that steps through a buffer (`p += n; memcpy(p, ...)`) stays checked without
+ * re-deriving sizes. The cursor never moves past end, so the space left is
+ * always end - cursor: as in checked_memcpy_offset, it cannot wrap, and each
+ * operation checks its count against it with a single compare. sc_ccursor is
+ * the read-only counterpart. Both are three pointers wide. The aborting
+ * functions abort on an out-of-range request and the try_ functions return
+ * ERR_POTENTIAL_BUFFER_OVERFLOW and leave the cursor untouched.
+ */
+typedef struct sc_cursor {
+  unsigned char* base;
+  unsigned char* cursor;
+  unsigned char* end;
+} sc_cursor;
+
+typedef struct sc_ccursor {
+  const unsigned char* base;
+  const unsigned char* cursor;
+  const unsigned char* end;
+} sc_ccursor;
+
+static inline sc_cursor sc_cursor_make(void* base, size_t size) {
+  sc_cursor cursor = {
+      (unsigned char*)base, (unsigned char*)base, (unsigned char*)base + size};
+  return cursor;
+}
+
+static inline sc_ccursor sc_ccursor_make(const void* base, size_t size) {
+  sc_ccursor cursor = {
+      (const unsigned char*)base,
+      (const unsigned char*)base,
+      (const unsigned char*)base + size};
+  return cursor;
+}
+
+static inline sc_cursor sc_cursor_from_span(sc_span span) {
+  return sc_cursor_make(span.ptr, span.len);
+}
+
+static inline sc_ccursor sc_ccursor_from_cspan(sc_cspan span) {
+  return sc_ccursor_make(span.ptr, span.len);
+}
+
+/**
+ * Returns the number of bytes between the cursor and the end of the buffer.
+ */
+static inline size_t sc_cursor_remaining(const sc_cursor* cursor) {
+  return (size_t)(cursor->end - cursor->cursor);
+}
+
+static inline size_t sc_ccursor_remaining(const sc_ccursor* cursor) {
+  return (size_t)(cursor->end - cursor->cursor);
+}
+
+/**
+ * Returns the number of bytes between the start of the buffer and the cursor.
+ */
+static inline size_t sc_cursor_offset(const sc_cursor* cursor) {
+  return (size_t)(cursor->cursor - cursor->base);
+}
+
+static inline size_t sc_ccursor_offset(const sc_ccursor* cursor) {
+  return (size_t)(cursor->cursor - cursor->base);
+}
+
+/**
+ * Moves the cursor forward by count bytes.
+ */
+static inline void sc_cursor_advance(sc_cursor* cursor, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    buffer_overflow_error_with_size(
+        __func__, sc_cursor_remaining(cursor), count);
+  }
+  cursor->cursor += count;
+}
+
+static inline void sc_ccursor_advance(sc_ccursor* cursor, size_t count) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    buffer_oob_read_error(__func__);
+  }
+  cursor->cursor += count;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_cursor_advance(
+    sc_cursor* cursor,
+    size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  cursor->cursor += count;
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_ccursor_advance(
+    sc_ccursor* cursor,
+    size_t count) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  cursor->cursor += count;
+  return 0;
+}
+
+/**
+ * Copies count bytes from source to the cursor and moves past them.
+ */
+static inline void
+sc_cursor_write(sc_cursor* cursor, const void* source, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    buffer_overflow_error_with_size(
+        __func__, sc_cursor_remaining(cursor), count);
+  }
+  memcpy(cursor->cursor, source, count);
+  cursor->cursor += count;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cursor_write(sc_cursor* cursor, const void* source, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  memcpy(cursor->cursor, source, count);
+  cursor->cursor += count;
+  return 0;
+}
+
+/**
+ * Copies count bytes at the cursor to destination without moving the cursor.
+ * destination must have room for count bytes.
+ */
+static inline void
+sc_cursor_peek(const sc_cursor* cursor, void* destination, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    buffer_oob_read_error(__func__);
+  }
+  memcpy(destination, cursor->cursor, count);
+}
+
+static inline void
+sc_ccursor_peek(const sc_ccursor* cursor, void* destination, size_t count) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    buffer_oob_read_error(__func__);
+  }
+  memcpy(destination, cursor->cursor, count);
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cursor_peek(const sc_cursor* cursor, void* destination, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  memcpy(destination, cursor->cursor, count);
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_ccursor_peek(const sc_ccursor* cursor, void* destination, size_t count) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  memcpy(destination, cursor->cursor, count);
+  return 0;
+}
+
+/**
+ * Copies count bytes at the cursor to destination and moves past them.
+ * destination must have room for count bytes.
+ */
+static inline void
+sc_cursor_read(sc_cursor* cursor, void* destination, size_t count) {
+  sc_cursor_peek(cursor, destination, count);
+  cursor->cursor += count;
+}
+
+static inline void
+sc_ccursor_read(sc_ccursor* cursor, void* destination, size_t count) {
+  sc_ccursor_peek(cursor, destination, count);
+  cursor->cursor += count;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cursor_read(sc_cursor* cursor, void* destination, size_t count) {
+  if (count > sc_cursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  memcpy(destination, cursor->cursor, count);
+  cursor->cursor += count;
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_ccursor_read(sc_ccursor* cursor, void* destination, size_t count) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  memcpy(destination, cursor->cursor, count);
+  cursor->cursor += count;
+  return 0;
+}
+
+/**
+ * Returns the count bytes at the cursor as a span and moves past them,
+ * without copying.
+ */
+static inline sc_span sc_cursor_take(sc_cursor* cursor, size_t count) {
+  unsigned char* const ptr = cursor->cursor;
+  sc_cursor_advance(cursor, count);
+  return sc_span_make(ptr, count);
+}
+
+static inline sc_cspan sc_ccursor_take(sc_ccursor* cursor, size_t count) {
+  const unsigned char* const ptr = cursor->cursor;
+  sc_ccursor_advance(cursor, count);
+  return sc_cspan_make(ptr, count);
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cursor_take(sc_cursor* cursor, size_t count, sc_span* out) {
+  if (count > sc_cursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_span_make(cursor->cursor, count);
+  cursor->cursor += count;
+  return 0;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_ccursor_take(sc_ccursor* cursor, size_t count, sc_cspan* out) {
+  if (count > sc_ccursor_remaining(cursor)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_cspan_make(cursor->cursor, count);
+  cursor->cursor += count;
+  return 0;
+}
+
+/*
+ * Wire encoding.
+ *
+ * Fixed-width little- and big-endian integers, LEB128 varints and blobs
+ * prefixed with their varint length, written through an sc_cursor and read
+ * zero-copy through an sc_ccursor. When the size of a message is known, check
+ * it once with try_sc_cursor_reserve() (or try_sc_ccursor_require() when
+ * reading) and then use the aborting sc_put_ and sc_get_ functions, which can
+ * then never fail; their per-field compare is a never-taken branch instead of
+ * an error path. The try_ functions suit fields whose size is not known up
+ * front; they return ERR_POTENTIAL_BUFFER_OVERFLOW (or, for a malformed
+ * varint, ERR_POTENTIAL_INTEGER_OVERFLOW) and leave the cursor untouched.
+ */
+
+/**
+ * Checks that size more bytes can be written at the cursor.
+ *
+ * @return int
+ *      Returns zero if they fit and ERR_POTENTIAL_BUFFER_OVERFLOW otherwise.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_cursor_reserve(const sc_cursor* cursor, size_t size) {
+  return size > sc_cursor_remaining(cursor) ? ERR_POTENTIAL_BUFFER_OVERFLOW
+                                            : 0;
+}
+
+/**
+ * Checks that size more bytes can be read at the cursor.
+ *
+ * @return int
+ *      Returns zero if they are available and ERR_POTENTIAL_BUFFER_OVERFLOW
+ * otherwise.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_ccursor_require(const sc_ccursor* cursor, size_t size) {
+  return size > sc_ccursor_remaining(cursor) ? ERR_POTENTIAL_BUFFER_OVERFLOW
+                                             : 0;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SAFEC_WIRE_UNROLL _Pragma("GCC unroll 8")
+#else
+#define SAFEC_WIRE_UNROLL
+#endif
+#define SAFEC_WIRE_LE_SHIFT(i, size) (8 * (i))
+#define SAFEC_WIRE_BE_SHIFT(i, size) (8 * ((size) - 1 - (i)))
+
+// Defines sc_put_<name>, try_sc_put_<name>, sc_get_<name> and
+// try_sc_get_<name> for a size-byte integer. The unrolled byte loops compile
+// to a single (byte-swapped where needed) load or store.
+#define SAFEC_DEFINE_WIRE_INT(name, type, size, shift)                 \
+  static inline void safec_wire_store_##name(                          \
+      unsigned char* out, type value) {                                \
+    SAFEC_WIRE_UNROLL                                                  \
+    for (unsigned i = 0; i < (size); ++i) {                            \
+      out[i] = (unsigned char)(value >> shift(i, size));               \
+    }                                                                  \
+  }                                                                    \
+  static inline type safec_wire_load_##name(const unsigned char* in) { \
+    type value = 0;                                                    \
+    SAFEC_WIRE_UNROLL                                                  \
+    for (unsigned i = 0; i < (size); ++i) {                            \
+      value = (type)(value | (type)((type)in[i] << shift(i, size)));   \
+    }                                                                  \
+    return value;                                                      \
+  }                                                                    \
+  static inline void sc_put_##name(sc_cursor* cursor, type value) {    \
+    unsigned char* const out = cursor->cursor;                         \
+    if (sc_cursor_remaining(cursor) < (size)) {                        \
+      buffer_overflow_error_with_size(                                 \
+          __func__, sc_cursor_remaining(cursor), (size));              \
+    }                                                                  \
+    safec_wire_store_##name(out, value);                               \
+    cursor->cursor = out + (size);                                     \
+  }                                                                    \
+  SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_put_##name(   \
+      sc_cursor* cursor, type value) {                                 \
+    unsigned char* const out = cursor->cursor;                         \
+    if (sc_cursor_remaining(cursor) < (size)) {                        \
+      return ERR_POTENTIAL_BUFFER_OVERFLOW;                            \
+    }                                                                  \
+    safec_wire_store_##name(out, value);                               \
+    cursor->cursor = out + (size);                                     \
+    return 0;                                                          \
+  }                                                                    \
+  static inline type sc_get_##name(sc_ccursor* cursor) {               \
+    const unsigned char* const in = cursor->cursor;                    \
+    if (sc_ccursor_remaining(cursor) < (size)) {                       \
+      buffer_oob_read_error(__func__);                                 \
+    }                                                                  \
+    cursor->cursor = in + (size);                                      \
+    return safec_wire_load_##name(in);                                 \
+  }                                                                    \
+  SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_get_##name(   \
+      sc_ccursor* cursor, type* out) {                                 \
+    const unsigned char* const in = cursor->cursor;                    \
+    if (sc_ccursor_remaining(cursor) < (size)) {                       \
+      return ERR_POTENTIAL_BUFFER_OVERFLOW;                            \
+    }                                                                  \
+    *out = safec_wire_load_##name(in);                                 \
+    cursor->cursor = in + (size);                                      \
+    return 0;                                                          \
+  }
+
+SAFEC_DEFINE_WIRE_INT(u8, uint8_t, 1, SAFEC_WIRE_LE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u16le, uint16_t, 2, SAFEC_WIRE_LE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u16be, uint16_t, 2, SAFEC_WIRE_BE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u32le, uint32_t, 4, SAFEC_WIRE_LE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u32be, uint32_t, 4, SAFEC_WIRE_BE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u64le, uint64_t, 8, SAFEC_WIRE_LE_SHIFT)
+SAFEC_DEFINE_WIRE_INT(u64be, uint64_t, 8, SAFEC_WIRE_BE_SHIFT)
+
+#undef SAFEC_DEFINE_WIRE_INT
+#undef SAFEC_WIRE_LE_SHIFT
+#undef SAFEC_WIRE_BE_SHIFT
+#undef SAFEC_WIRE_UNROLL
+
+#define SC_VARINT_MAX_SIZE 10
+
+/**
+ * Returns the number of bytes sc_put_varint() writes for value.
+ */
+static inline size_t sc_varint_size(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 1 + (size_t)(63 - __builtin_clzll(value | 1)) / 7;
+#else
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+#endif
+}
+
+/**
+ * Returns the number of bytes sc_put_blob() writes for a blob of size bytes,
+ * or SIZE_MAX if that does not fit in size_t (which no reservation passes).
+ */
+static inline size_t sc_blob_size(size_t size) {
+  size_t total;
+  if (try_checked_add_size(sc_varint_size(size), size, &total) != 0) {
+    return SIZE_MAX;
+  }
+  return total;
+}
+
+static inline void safec_wire_store_varint(sc_cursor* cursor, uint64_t value) {
+  unsigned char* out = cursor->cursor;
+  while (value >= 0x80) {
+    *out++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (unsigned char)value;
+  cursor->cursor = out;
+}
+
+/**
+ * Writes value as an unsigned LEB128 varint.
+ */
+static inline void sc_put_varint(sc_cursor* cursor, uint64_t value) {
+  const size_t size = sc_varint_size(value);
+  if (sc_cursor_remaining(cursor) < size) {
+    buffer_overflow_error_with_size(
+        __func__, sc_cursor_remaining(cursor), size);
+  }
+  safec_wire_store_varint(cursor, value);
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_put_varint(
+    sc_cursor* cursor,
+    uint64_t value) {
+  if (sc_cursor_remaining(cursor) < sc_varint_size(value)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  safec_wire_store_varint(cursor, value);
+  return 0;
+}
+
+/**
+ * Reads an unsigned LEB128 varint.
+ *
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_BUFFER_OVERFLOW if the input
+ * ends inside the varint and ERR_POTENTIAL_INTEGER_OVERFLOW if it encodes
+ * more than 64 bits.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_get_varint(
+    sc_ccursor* cursor,
+    uint64_t* out) {
+  const unsigned char* in = cursor->cursor;
+  const size_t available = sc_ccursor_remaining(cursor);
+  const size_t limit =
+      available < SC_VARINT_MAX_SIZE ? available : SC_VARINT_MAX_SIZE;
+  uint64_t value = 0;
+  for (size_t i = 0; i < limit; ++i) {
+    const unsigned char byte = in[i];
+    value |= (uint64_t)(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      // The tenth byte only has room for the top bit of a 64-bit value.
+      if (i == SC_VARINT_MAX_SIZE - 1 && byte > 1) {
+        return ERR_POTENTIAL_INTEGER_OVERFLOW;
+      }
+      *out = value;
+      cursor->cursor = in + i + 1;
+      return 0;
+    }
+  }
+  return limit == SC_VARINT_MAX_SIZE ? ERR_POTENTIAL_INTEGER_OVERFLOW
+                                     : ERR_POTENTIAL_BUFFER_OVERFLOW;
+}
+
+/**
+ * Reads an unsigned LEB128 varint, aborting if the input ends inside it or it
+ * encodes more than 64 bits.
+ */
+static inline uint64_t sc_get_varint(sc_ccursor* cursor) {
+  uint64_t value;
+  const int error = try_sc_get_varint(cursor, &value);
+  if (error == ERR_POTENTIAL_INTEGER_OVERFLOW) {
+    integer_overflow_error(__func__);
+  }
+  if (error != 0) {
+    buffer_oob_read_error(__func__);
+  }
+  return value;
+}
+
+/**
+ * Writes size bytes from source prefixed with their varint length.
+ */
+static inline void
+sc_put_blob(sc_cursor* cursor, const void* source, size_t size) {
+  const size_t total = sc_blob_size(size);
+  if (sc_cursor_remaining(cursor) < total) {
+    buffer_overflow_error_with_size(
+        __func__, sc_cursor_remaining(cursor), total);
+  }
+  safec_wire_store_varint(cursor, size);
+  memcpy(cursor->cursor, source, size);
+  cursor->cursor += size;
+}
+
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_put_blob(sc_cursor* cursor, const void* source, size_t size) {
+  if (sc_cursor_remaining(cursor) < sc_blob_size(size)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  safec_wire_store_varint(cursor, size);
+  memcpy(cursor->cursor, source, size);
+  cursor->cursor += size;
+  return 0;
+}
+
+/**
+ * Reads a length-prefixed blob without copying it.
+ *
+ * @param out
+ *      Receives the blob contents, which point into the input.
+ * @return int
+ *      Returns zero on success and the try_sc_get_varint() errors or
+ * ERR_POTENTIAL_BUFFER_OVERFLOW if the input is shorter than the prefix says.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_get_blob(
+    sc_ccursor* cursor,
+    sc_cspan* out) {
+  sc_ccursor next = *cursor;
+  uint64_t size;
+  const int error = try_sc_get_varint(&next, &size);
+  if (error != 0) {
+    return error;
+  }
+  if (size > sc_ccursor_remaining(&next)) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_cspan_make(next.cursor, (size_t)size);
+  cursor->cursor = next.cursor + size;
+  return 0;
+}
+
+/**
+ * Reads a length-prefixed blob without copying it, aborting on the errors
+ * try_sc_get_blob() returns.
+ *
+ * @return sc_cspan
+ *      Returns the blob contents, which point into the input.
+ */
+static inline sc_cspan sc_get_blob(sc_ccursor* cursor) {
+  sc_cspan blob;
+  const int error = try_sc_get_blob(cursor, &blob);
+  if (error == ERR_POTENTIAL_INTEGER_OVERFLOW) {
+    integer_overflow_error(__func__);
+  }
+  if (error != 0) {
+    buffer_oob_read_error(__func__);
+  }
+  return blob;
+}
+
+#ifdef SAFEC_EXTENT_REGISTRY
+
+/*
+ * Extent registry.
+ *
+ * Defining SAFEC_EXTENT_REGISTRY makes the array allocators and, with
+ * SAFEC_GUARDED_ALLOC, sc_guarded_alloc() record every block they return in a
+ * process-wide page map. checked_memcpy_auto then looks up the block that
+ * contains its destination and bounds the copy by the bytes from the
+ * destination to the end of that block, so appending at buf + off is checked
+ * as well. Other buffers can be added with try_sc_extent_register(). Blocks
+ * from the array allocators must be released with checked_free_array() so
+ * that their entries go away.
+ *
+ * The page map is a radix tree over the 4 KiB pages of a 48-bit address
+ * space. Each page has one cache line giving, for each of its 256-byte
+ * granules, the extent starting closest below the granule's end, and
+ * separately names the one extent that starts before the page and runs into
+ * it. A lookup takes no lock and costs three dependent loads (leaf, granule,
+ * extent), plus one for each other extent that starts between the
+ * destination and the end of its granule. Registration and removal are
+ * serialized by a mutex and touch one entry per page a block spans. The map
+ * is never shrunk: a leaf covers 1 GiB, is allocated on first use and kept.
+ *
+ * With SAFEC_EXTENT_MALLOC_FALLBACK, a destination outside every registered
+ * extent is bounded by the size of the malloc() block starting at it. On
+ * Apple platforms malloc_size() checks that the destination starts a live
+ * block and anything else is an error. glibc's malloc_usable_size() cannot
+ * tell, so there the program must only pass unregistered destinations that
+ * start a live malloc() block; anything else is undefined behavior.
+ */
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC extent registry requires a GCC-compatible compiler on POSIX"
+#endif
+
+#if defined(SAFEC_EXTENT_MALLOC_FALLBACK) && !defined(__APPLE__) && \
+    !defined(__linux__)
+#error "SAFEC_EXTENT_MALLOC_FALLBACK requires malloc_size or malloc_usable_size"
+#endif
+
+#ifndef SAFEC_EXTENT_REGISTRY_CAPACITY
+#define SAFEC_EXTENT_REGISTRY_CAPACITY 65536 // live extents, below 2^32
+#endif
+#define SAFEC_EXTENT_ADDRESS_BITS 48
+#define SAFEC_EXTENT_PAGE_SHIFT 12
+#define SAFEC_EXTENT_GRANULE_SHIFT 8
+#define SAFEC_EXTENT_GRANULES \
+  ((size_t)1 << (SAFEC_EXTENT_PAGE_SHIFT - SAFEC_EXTENT_GRANULE_SHIFT))
+// Each leaf maps 1 GiB of pages.
+#define SAFEC_EXTENT_LEAF_BITS 18
+#define SAFEC_EXTENT_LEAF_PAGES ((size_t)1 << SAFEC_EXTENT_LEAF_BITS)
+#define SAFEC_EXTENT_ROOT_SIZE                                         \
+  ((size_t)1 << (SAFEC_EXTENT_ADDRESS_BITS - SAFEC_EXTENT_PAGE_SHIFT - \
+                 SAFEC_EXTENT_LEAF_BITS))
+#define SAFEC_EXTENT_CACHE_LINE 64
+
+struct safec_extent {
+  uintptr_t base;
+  size_t size;
+  // Next extent starting lower in the same page, or the next free index.
+  uint32_t next;
+};
+
+// For each granule, the first extent starting in the page at or below the
+// granule's last byte. The last granule thus heads the list of all extents
+// starting in the page, highest base first.
+struct safec_extent_page {
+  uint32_t granules[SAFEC_EXTENT_GRANULES];
+};
+
+struct safec_extent_leaf {
+  // Cache-line aligned, so that a lookup touches one line of pages.
+  struct safec_extent_page pages[SAFEC_EXTENT_LEAF_PAGES];
+  // The extent starting before each page and running into it.
+  uint32_t cover[SAFEC_EXTENT_LEAF_PAGES];
+};
+
+// Extents are referred to by index; index 0 means none.
+__attribute__((weak)) struct safec_extent
+    safec_extent_registry[SAFEC_EXTENT_REGISTRY_CAPACITY + 1];
+__attribute__((weak)) uint32_t safec_extent_registry_used;
+__attribute__((weak)) uint32_t safec_extent_registry_free;
+__attribute__((weak)) struct safec_extent_leaf*
+    safec_extent_root[SAFEC_EXTENT_ROOT_SIZE];
+// Writers take the lock and keep the sequence odd while they change the map;
+// lookups take no lock and retry if the sequence changed under them. Shared
+// fields are stored with release and loaded with acquire semantics, so a
+// lookup that reads any change also reads the odd sequence before it.
+__attribute__((weak)) pthread_mutex_t safec_extent_registry_lock =
+    PTHREAD_MUTEX_INITIALIZER;
+__attribute__((weak)) unsigned long safec_extent_registry_sequence;
+
+static inline void safec_extent_write_begin(void) {
+  pthread_mutex_lock(&safec_extent_registry_lock);
+  __atomic_store_n(
+      &safec_extent_registry_sequence,
+      safec_extent_registry_sequence + 1,
+      __ATOMIC_RELAXED);
+}
+
+static inline void safec_extent_write_end(void) {
+  __atomic_store_n(
+      &safec_extent_registry_sequence,
+      safec_extent_registry_sequence + 1,
+      __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&safec_extent_registry_lock);
+}
+
+// Returns the leaf mapping a page below 2^36, or NULL if it does not exist
+// yet.
+static inline struct safec_extent_leaf* safec_extent_leaf(uint64_t page) {
+  return __atomic_load_n(
+      &safec_extent_root[page >> SAFEC_EXTENT_LEAF_BITS], __ATOMIC_ACQUIRE);
+}
+
+// Allocates the leaf mapping a page if it is missing. Callers hold the lock.
+static inline int safec_extent_leaf_create(uint64_t page) {
+  struct safec_extent_leaf** const leaf =
+      &safec_extent_root[page >> SAFEC_EXTENT_LEAF_BITS];
+  if (*leaf == BAD_PTR) {
+    // Leaves are large and mostly untouched; calloc() maps them lazily. They
+    // are never freed, so the unaligned start of the block can be dropped.
+    unsigned char* const block = (unsigned char*)calloc(
+        1, sizeof(struct safec_extent_leaf) + SAFEC_EXTENT_CACHE_LINE - 1);
+    if (block == BAD_PTR) {
+      return ERR_OUT_OF_MEMORY;
+    }
+    const size_t misalignment =
+        (uintptr_t)block & (SAFEC_EXTENT_CACHE_LINE - 1);
+    __atomic_store_n(
+        leaf,
+        (struct safec_extent_leaf*)(block +
+                                    (misalignment != 0
+                                         ? SAFEC_EXTENT_CACHE_LINE -
+                                             misalignment
+                                         : 0)),
+        __ATOMIC_RELEASE);
+  }
+  return 0;
+}
+
+// Returns the granule entries of a page whose leaf exists.
+static inline uint32_t* safec_extent_granules(uint64_t page) {
+  return safec_extent_leaf(page)
+      ->pages[page & (SAFEC_EXTENT_LEAF_PAGES - 1)]
+      .granules;
+}
+
+// Returns the covering entry of a page whose leaf exists.
+static inline uint32_t* safec_extent_cover(uint64_t page) {
+  return &safec_extent_leaf(page)->cover[page & (SAFEC_EXTENT_LEAF_PAGES - 1)];
+}
+
+// Returns the last page of an extent. Empty extents occupy the page of their
+// base.
+static inline uint64_t safec_extent_last_page(uintptr_t base, size_t size) {
+  return (uint64_t)(base + (size != 0 ? size - 1 : 0)) >>
+      SAFEC_EXTENT_PAGE_SHIFT;
+}
+
+static inline size_t safec_extent_granule(uintptr_t address) {
+  return (size_t)(address >> SAFEC_EXTENT_GRANULE_SHIFT) &
+      (SAFEC_EXTENT_GRANULES - 1);
+}
+
+// Returns the index of the extent containing address and sets *remaining to
+// the bytes from address to its end, or returns 0. An empty extent contains
+// only its base. Lookups call this between sequence checks, which discard
+// whatever a concurrent writer made it read.
+static inline uint32_t safec_extent_find(
+    uintptr_t address,
+    size_t* remaining) {
+  if ((uint64_t)address >> SAFEC_EXTENT_ADDRESS_BITS != 0) {
+    return 0;
+  }
+  const uint64_t page = (uint64_t)address >> SAFEC_EXTENT_PAGE_SHIFT;
+  const struct safec_extent_leaf* const leaf = safec_extent_leaf(page);
+  if (leaf == BAD_PTR) {
+    return 0;
+  }
+  const size_t slot = page & (SAFEC_EXTENT_LEAF_PAGES - 1);
+  // The first extent of the page at or below address is the only one that
+  // can contain it; if there is none, only the covering extent can. Entry 0
+  // has base 0 and size 0, so it ends the walk and contains nothing. The walk
+  // is bounded because a concurrent writer may relink the list.
+  uint32_t index = __atomic_load_n(
+      &leaf->pages[slot].granules[safec_extent_granule(address)],
+      __ATOMIC_ACQUIRE);
+  const uint32_t cover = __atomic_load_n(&leaf->cover[slot], __ATOMIC_ACQUIRE);
+  for (size_t steps = 0;
+       steps < SAFEC_EXTENT_REGISTRY_CAPACITY &&
+       __atomic_load_n(&safec_extent_registry[index].base, __ATOMIC_ACQUIRE) >
+           address;
+       ++steps) {
+    index =
+        __atomic_load_n(&safec_extent_registry[index].next, __ATOMIC_ACQUIRE);
+  }
+  // Selecting rather than branching, as whether the page has a start below
+  // address is hard to predict.
+  index = index != 0 ? index : cover;
+  const struct safec_extent* const extent = &safec_extent_registry[index];
+  const uintptr_t offset =
+      address - __atomic_load_n(&extent->base, __ATOMIC_ACQUIRE);
+  const size_t size = __atomic_load_n(&extent->size, __ATOMIC_ACQUIRE);
+  if (offset >= size && offset != 0) {
+    return 0;
+  }
+  *remaining = size - offset;
+  return index;
+}
+
+// Returns the index of an extent overlapping the size bytes at base (or base
+// itself if size is 0), or 0. Callers hold the lock and have created the
+// leaves of the range.
+static inline uint32_t safec_extent_overlap(uintptr_t base, size_t size) {
+  size_t remaining;
+  const uint32_t containing = safec_extent_find(base, &remaining);
+  if (containing != 0) {
+    return containing;
+  }
+  // Anything else overlapping starts inside the range.
+  const uint64_t last = safec_extent_last_page(base, size);
+  for (uint64_t page = (uint64_t)base >> SAFEC_EXTENT_PAGE_SHIFT;
+       page <= last;
+       ++page) {
+    for (uint32_t index =
+             safec_extent_granules(page)[SAFEC_EXTENT_GRANULES - 1];
+         index != 0;
+         index = safec_extent_registry[index].next) {
+      const uintptr_t start = safec_extent_registry[index].base;
+      if (start > base && start - base < size) {
+        return index;
+      }
+    }
+  }
+  return 0;
+}
+
+// Unlinks an extent from the map and frees its index. Callers hold the lock.
+static inline void safec_extent_remove(uint32_t index) {
+  struct safec_extent* const extent = &safec_extent_registry[index];
+  const uint64_t first = (uint64_t)extent->base >> SAFEC_EXTENT_PAGE_SHIFT;
+  const uint64_t last = safec_extent_last_page(extent->base, extent->size);
+  uint32_t* const granules = safec_extent_granules(first);
+  // The next higher extent in the page links to it, or the last granule if
+  // there is none, and so do the granules from its own up to the next higher
+  // start; all of them now skip it.
+  uint32_t* link = &granules[SAFEC_EXTENT_GRANULES - 1];
+  while (*link != index) {
+    link = &safec_extent_registry[*link].next;
+  }
+  if (link != &granules[SAFEC_EXTENT_GRANULES - 1]) {
+    __atomic_store_n(link, extent->next, __ATOMIC_RELEASE);
+  }
+  for (size_t granule = safec_extent_granule(extent->base);
+       granule < SAFEC_EXTENT_GRANULES && granules[granule] == index;
+       ++granule) {
+    __atomic_store_n(&granules[granule], extent->next, __ATOMIC_RELEASE);
+  }
+  for (uint64_t page = first + 1; page <= last; ++page) {
+    __atomic_store_n(safec_extent_cover(page), 0, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&extent->next, safec_extent_registry_free, __ATOMIC_RELEASE);
+  safec_extent_registry_free = index;
+}
+
+// Links a new extent into the map. Callers hold the lock and have created its
+// leaves.
+static inline void safec_extent_link(uint32_t index) {
+  struct safec_extent* const extent = &safec_extent_registry[index];
+  const uintptr_t key = extent->base;
+  const uint64_t first = (uint64_t)key >> SAFEC_EXTENT_PAGE_SHIFT;
+  const uint64_t last = safec_extent_last_page(key, extent->size);
+  uint32_t* const granules = safec_extent_granules(first);
+  const size_t own = safec_extent_granule(key);
+  // The extent goes after those starting higher in the page, the lowest of
+  // which is reached from the first granule leading to any of them.
+  uint32_t* link = BAD_PTR;
+  for (size_t granule = own; granule < SAFEC_EXTENT_GRANULES; ++granule) {
+    if (granules[granule] != 0 &&
+        safec_extent_registry[granules[granule]].base > key) {
+      uint32_t higher = granules[granule];
+      while (safec_extent_registry[higher].next != 0 &&
+             safec_extent_registry[safec_extent_registry[higher].next].base >
+                 key) {
+        higher = safec_extent_registry[higher].next;
+      }
+      link = &safec_extent_registry[higher].next;
+      break;
+    }
+  }
+  uint32_t next = link != BAD_PTR ? *link : granules[own];
+  while (next != 0 && safec_extent_registry[next].base > key) {
+    next = safec_extent_registry[next].next;
+  }
+  __atomic_store_n(&extent->next, next, __ATOMIC_RELEASE);
+  if (link != BAD_PTR) {
+    __atomic_store_n(link, index, __ATOMIC_RELEASE);
+  }
+  // Granules from the extent's own up to the next higher start now lead to
+  // it.
+  for (size_t granule = own; granule < SAFEC_EXTENT_GRANULES &&
+       (granules[granule] == 0 ||
+        safec_extent_registry[granules[granule]].base < key);
+       ++granule) {
+    __atomic_store_n(&granules[granule], index, __ATOMIC_RELEASE);
+  }
+  for (uint64_t page = first + 1; page <= last; ++page) {
+    __atomic_store_n(safec_extent_cover(page), index, __ATOMIC_RELEASE);
+  }
+}
+
+// Takes the address as an integer so that registering a freshly allocated,
+// uninitialized block does not look like a read of its contents.
+static inline int safec_extent_insert(uintptr_t key, size_t size) {
+  if (key == 0 || (size != 0 && key + (size - 1) < key) ||
+      safec_extent_last_page(key, size) >>
+              (SAFEC_EXTENT_ADDRESS_BITS - SAFEC_EXTENT_PAGE_SHIFT) !=
+          0) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  const uint64_t first = (uint64_t)key >> SAFEC_EXTENT_PAGE_SHIFT;
+  const uint64_t last = safec_extent_last_page(key, size);
+  int error = 0;
+  safec_extent_write_begin();
+  // Create the leaves first so that a failed allocation changes nothing.
+  for (uint64_t leaf = first >> SAFEC_EXTENT_LEAF_BITS;
+       leaf <= last >> SAFEC_EXTENT_LEAF_BITS && error == 0;
+       ++leaf) {
+    error = safec_extent_leaf_create(leaf << SAFEC_EXTENT_LEAF_BITS);
+  }
+  if (error == 0) {
+    // Live blocks cannot overlap, so anything the range overlaps is stale:
+    // the same block registered again, or one released with free().
+    uint32_t stale;
+    while ((stale = safec_extent_overlap(key, size)) != 0) {
+      safec_extent_remove(stale);
+    }
+    uint32_t index = safec_extent_registry_free;
+    if (index != 0) {
+      safec_extent_registry_free = safec_extent_registry[index].next;
+    } else if (safec_extent_registry_used < SAFEC_EXTENT_REGISTRY_CAPACITY) {
+      index = ++safec_extent_registry_used;
+    } else {
+      error = ERR_OUT_OF_MEMORY;
+    }
+    if (index != 0) {
+      __atomic_store_n(
+          &safec_extent_registry[index].base, key, __ATOMIC_RELEASE);
+      __atomic_store_n(
+          &safec_extent_registry[index].size, size, __ATOMIC_RELEASE);
+      safec_extent_link(index);
+    }
+  }
+  safec_extent_write_end();
+  return error;
+}
+
+/**
+ * Records that size bytes starting at base may be written. Any registered
+ * extents the range overlaps are dropped first, since they can only be stale;
+ * registering base again thus updates its size.
+ *
+ * @return int
+ *      Returns zero on success, ERR_INVALID_ARGUMENT if base is null or the
+ * range does not fit in a 48-bit address space, and ERR_OUT_OF_MEMORY if the
+ * registry already holds SAFEC_EXTENT_REGISTRY_CAPACITY extents or the page
+ * map could not grow.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_extent_register(const void* base, size_t size) {
+  return safec_extent_insert((uintptr_t)base, size);
+}
+
+/**
+ * Removes the extent starting at base from the registry. Other addresses are
+ * ignored.
+ */
+static inline void sc_extent_unregister(const void* base) {
+  const uintptr_t key = (uintptr_t)base;
+  if (key == 0) {
+    return;
+  }
+  safec_extent_write_begin();
+  size_t remaining;
+  const uint32_t index = safec_extent_find(key, &remaining);
+  if (index != 0 && safec_extent_registry[index].base == key) {
+    safec_extent_remove(index);
+  }
+  safec_extent_write_end();
+}
+
+/**
+ * Looks up the number of bytes that may be written through pointer, i.e. up
+ * to the end of the registered block containing it.
+ *
+ * @return int
+ *      Returns 1 and sets *size if pointer is inside a registered block (or,
+ * with SAFEC_EXTENT_MALLOC_FALLBACK, starts a live malloc() block) and 0
+ * otherwise.
+ */
+static inline int sc_extent_lookup(const void* pointer, size_t* size) {
+  const uintptr_t address = (uintptr_t)pointer;
+  if (address != 0) {
+    for (;;) {
+      const unsigned long sequence = __atomic_load_n(
+          &safec_extent_registry_sequence, __ATOMIC_ACQUIRE);
+      if ((sequence & 1) != 0) {
+        continue;
+      }
+      size_t remaining = 0;
+      const uint32_t index = safec_extent_find(address, &remaining);
+      if (__atomic_load_n(&safec_extent_registry_sequence, __ATOMIC_RELAXED) ==
+          sequence) {
+        if (index != 0) {
+          *size = remaining;
+          return 1;
+        }
+        break;
+      }
+    }
+  }
+#ifdef SAFEC_EXTENT_MALLOC_FALLBACK
+#ifdef __APPLE__
+  // malloc_size() returns 0 unless pointer starts a live malloc() block.
+  const size_t block_size = pointer != BAD_PTR ? malloc_size(pointer) : 0;
+#else
+  // The caller guarantees that pointer starts a live malloc() block.
+  const size_t block_size =
+      pointer != BAD_PTR ? malloc_usable_size((void*)pointer) : 0;
+#endif
+  if (block_size != 0) {
+    *size = block_size;
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+// Evaluates to zero, or to an error if the block could not be registered;
+// the allocators then release the block and return ERR_OUT_OF_MEMORY.
+#define SAFEC_EXTENT_TRACK(base, size) \
+  safec_extent_insert((uintptr_t)(base), (size))
+#define SAFEC_EXTENT_UNTRACK(base) sc_extent_unregister(base)
+
+/**
+ * Bounds checking wrapper for std::memcpy that takes the destination size
+ * from the extent registry. This version aborts the process if destination
+ * is not inside a registered block or if there's a possibility of buffer
+ * overflow.
+ *
+ * @param destination
+ *      Pointer into a registered block; at most the bytes from it to the end
+ * of the block are written.
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of bytes to copy.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void*
+checked_memcpy_auto(void* destination, const void* source, size_t count) {
+  size_t destination_size;
+  if (!sc_extent_lookup(destination, &destination_size)) {
+    invalid_argument_error(__func__);
+  }
+  SAFEC_OP(checked_memcpy_auto, destination, source, count, destination_size);
+  if (destination_size < count) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (source == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+  return SAFEC_OP_CALL(memcpy(destination, source, count));
+}
+
+/**
+ * Bounds checking wrapper for std::memcpy that takes the destination size
+ * from the extent registry. This version returns an error code instead of
+ * aborting. Error handling is mandatory.
+ *
+ * @return int
+ *      Returns zero on success, ERR_INVALID_ARGUMENT if destination is not
+ * inside a registered block and ERR_POTENTIAL_BUFFER_OVERFLOW if count
+ * exceeds the bytes from destination to the end of that block.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int
+try_checked_memcpy_auto(void* destination, const void* source, size_t count) {
+  size_t destination_size;
+  if (!sc_extent_lookup(destination, &destination_size)) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  SAFEC_OP(
+      try_checked_memcpy_auto, destination, source, count, destination_size);
+  if (destination_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  SAFEC_OP_CALL(memcpy(destination, source, count));
+  return 0;
+}
+
+#else
+#define SAFEC_EXTENT_TRACK(base, size) 0
+#define SAFEC_EXTENT_UNTRACK(base) ((void)0)
+#endif // SAFEC_EXTENT_REGISTRY
+
+/*
+ * Overflow-checked array allocation.
+ *
+ * The array allocators compute count * elem_size with try_checked_mul_size()
+ * and return the block as an sc_span whose len is its usable size in bytes;
+ * release it with checked_free_array(). A zero-sized request still returns a
+ * unique non-null pointer.
+ */
+
+/**
+ * Allocates uninitialized storage for count elements of elem_size bytes.
+ *
+ * @param out
+ *      Receives the allocation on success and is left untouched otherwise.
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_INTEGER_OVERFLOW if count *
+ * elem_size does not fit in size_t and ERR_OUT_OF_MEMORY if the allocation
+ * failed or, with SAFEC_EXTENT_REGISTRY, the block could not be registered.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_checked_malloc_array(size_t count, size_t elem_size, sc_span* out) {
+  size_t size;
+  if (try_checked_mul_size(count, elem_size, &size) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  void* block = malloc(size ? size : 1);
+  if (block == BAD_PTR) {
+    return ERR_OUT_OF_MEMORY;
+  }
+  if (SAFEC_EXTENT_TRACK(block, size) != 0) {
+    free(block);
+    return ERR_OUT_OF_MEMORY;
+  }
+  *out = sc_span_make(block, size);
+  return 0;
+}
+
+/**
+ * Allocates zeroed storage for count elements of elem_size bytes.
+ *
+ * @param out
+ *      Receives the allocation on success and is left untouched otherwise.
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_INTEGER_OVERFLOW if count *
+ * elem_size does not fit in size_t and ERR_OUT_OF_MEMORY if the allocation
+ * failed or, with SAFEC_EXTENT_REGISTRY, the block could not be registered.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_checked_calloc_array(size_t count, size_t elem_size, sc_span* out) {
+  size_t size;
+  if (try_checked_mul_size(count, elem_size, &size) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  void* block = calloc(1, size ? size : 1);
+  if (block == BAD_PTR) {
+    return ERR_OUT_OF_MEMORY;
+  }
+  if (SAFEC_EXTENT_TRACK(block, size) != 0) {
+    free(block);
+    return ERR_OUT_OF_MEMORY;
+  }
+  *out = sc_span_make(block, size);
+  return 0;
+}
+
+/**
+ * Resizes block to hold count elements of elem_size bytes, keeping the
+ * leading contents as realloc() does. block may be an empty span with a null
+ * pointer, in which case a new block is allocated.
+ *
+ * @param block
+ *      Allocation to resize; updated on success. On failure it is left
+ * untouched and still owned by the caller, except when the resized block
+ * could not be recorded in a full extent registry: it is then released and
+ * block is set to an empty span.
+ * @return int
+ *      Returns zero on success, ERR_POTENTIAL_INTEGER_OVERFLOW if count *
+ * elem_size does not fit in size_t and ERR_OUT_OF_MEMORY if the allocation
+ * failed or, with SAFEC_EXTENT_REGISTRY, the block could not be registered.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_checked_realloc_array(sc_span* block, size_t count, size_t elem_size) {
+  size_t size;
+  if (try_checked_mul_size(count, elem_size, &size) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  // Unregister first: once realloc() moves the block, its old address may be
+  // handed out and registered again by another thread.
+  SAFEC_EXTENT_UNTRACK(block->ptr);
+  void* resized = realloc(block->ptr, size ? size : 1);
+  if (resized == BAD_PTR) {
+    if (block->ptr != BAD_PTR) {
+      // The slot released above is normally still free; if the registry
+      // filled up meanwhile, the block stays valid but loses its entry.
+      (void)SAFEC_EXTENT_TRACK(block->ptr, block->len);
+    }
+    return ERR_OUT_OF_MEMORY;
+  }
+  if (SAFEC_EXTENT_TRACK(resized, size) != 0) {
+    free(resized);
+    *block = sc_span_make(BAD_PTR, 0);
+    return ERR_OUT_OF_MEMORY;
+  }
+  *block = sc_span_make(resized, size);
+  return 0;
+}
+
+/**
+ * Releases a block returned by one of the array allocators.
+ */
+static inline void checked_free_array(sc_span block) {
+  SAFEC_EXTENT_UNTRACK(block.ptr);
+  free(block.ptr);
+}
+
+static inline void safec_allocation_error(
+    const char* api_name,
+    int error,
+    size_t count,
+    size_t elem_size) {
+  if (error == ERR_POTENTIAL_INTEGER_OVERFLOW) {
+    integer_overflow_error(api_name);
+  }
+  if (error != 0) {
+    out_of_memory_error(api_name, count * elem_size);
+  }
+}
+
+/**
+ * Allocates uninitialized storage for count elements of elem_size bytes. This
+ * version aborts the process if the size overflows or the allocation fails.
+ */
+static inline sc_span checked_malloc_array(size_t count, size_t elem_size) {
+  sc_span out = sc_span_make(BAD_PTR, 0);
+  safec_allocation_error(
+      __func__,
+      try_checked_malloc_array(count, elem_size, &out),
+      count,
+      elem_size);
+  return out;
+}
+
+/**
+ * Allocates zeroed storage for count elements of elem_size bytes. This
+ * version aborts the process if the size overflows or the allocation fails.
+ */
+static inline sc_span checked_calloc_array(size_t count, size_t elem_size) {
+  sc_span out = sc_span_make(BAD_PTR, 0);
+  safec_allocation_error(
+      __func__,
+      try_checked_calloc_array(count, elem_size, &out),
+      count,
+      elem_size);
+  return out;
+}
+
+/**
+ * Resizes block to hold count elements of elem_size bytes and returns the
+ * resized allocation. This version aborts the process if the size overflows
+ * or the allocation fails.
+ */
+static inline sc_span
+checked_realloc_array(sc_span block, size_t count, size_t elem_size) {
+  safec_allocation_error(
+      __func__,
+      try_checked_realloc_array(&block, count, elem_size),
+      count,
+      elem_size);
+  return block;
+}
+
+/*
+ * Bump arena.
+ *
+ * sc_arena hands out sc_span regions from one block with a pointer bump, so
+ * every region carries its own size. All size arithmetic is overflow-checked.
+ * Reset is O(1); with SC_ARENA_WIPE_ON_RESET the bytes handed out since the
+ * previous reset are zeroed first, with a memset the compiler may not elide.
+ */
+#define SC_ARENA_WIPE_ON_RESET 1
+
+typedef struct sc_arena {
+  unsigned char* base;
+  size_t size;
+  size_t used;
+  unsigned flags;
+  int owns_block;
+} sc_arena;
+
+/**
+ * Zeroes count bytes at destination in a way the compiler cannot remove as a
+ * dead store, e.g. right before the memory is freed or reused.
+ */
+static inline void safec_secure_zero(void* destination, size_t count) {
+#if defined(__GNUC__) || defined(__clang__)
+  memset(destination, 0, count);
+  // The empty asm may read the memory, which keeps the memset alive while
+  // still letting the compiler use its vectorized memset.
+  __asm__ __volatile__("" : : "r"(destination) : "memory");
+#else
+  void* (*volatile do_memset)(void*, int, size_t) = memset;
+  do_memset(destination, 0, count);
+#endif
+}
+
+/**
+ * Initializes arena over the caller-owned block. flags is 0 or
+ * SC_ARENA_WIPE_ON_RESET.
+ */
+static inline void
+sc_arena_init(sc_arena* arena, sc_span block, unsigned flags) {
+  arena->base = block.ptr;
+  arena->size = block.len;
+  arena->used = 0;
+  arena->flags = flags;
+  arena->owns_block = 0;
+}
+
+/**
+ * Initializes arena over a newly allocated block of size bytes, released by
+ * sc_arena_destroy().
+ *
+ * @return int
+ *      Returns zero on success and ERR_OUT_OF_MEMORY if the block could not be
+ * allocated.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_arena_create(sc_arena* arena, size_t size, unsigned flags) {
+  sc_span block;
+  const int error = try_checked_malloc_array(size, 1, &block);
+  if (error != 0) {
+    return error;
+  }
+  sc_arena_init(arena, block, flags);
+  arena->owns_block = 1;
+  return 0;
+}
+
+/**
+ * Makes all regions handed out by arena available again, wiping them first
+ * if the arena was created with SC_ARENA_WIPE_ON_RESET.
+ */
+static inline void sc_arena_reset(sc_arena* arena) {
+  if ((arena->flags & SC_ARENA_WIPE_ON_RESET) && arena->used != 0) {
+    safec_secure_zero(arena->base, arena->used);
+  }
+  arena->used = 0;
+}
+
+/**
+ * Resets arena and releases its block if it was allocated by
+ * try_sc_arena_create().
+ */
+static inline void sc_arena_destroy(sc_arena* arena) {
+  sc_arena_reset(arena);
+  if (arena->owns_block) {
+    checked_free_array(sc_span_make(arena->base, arena->size));
+  }
+  arena->base = BAD_PTR;
+  arena->size = 0;
+  arena->owns_block = 0;
+}
+
+/**
+ * Returns the number of bytes still available for an allocation with the
+ * given alignment.
+ */
+static inline size_t sc_arena_remaining(
+    const sc_arena* arena,
+    size_t alignment) {
+  const size_t padding = alignment > 1
+      ? (size_t)(-(uintptr_t)(arena->base + arena->used) & (alignment - 1))
+      : 0;
+  const size_t available = arena->size - arena->used;
+  return padding > available ? 0 : available - padding;
+}
+
+/**
+ * Allocates size bytes aligned to alignment (a power of two, or 0 for no
+ * alignment) from arena.
+ *
+ * @param arena
+ *      Arena to allocate from.
+ * @param size
+ *      Number of bytes to allocate.
+ * @param alignment
+ *      Required alignment of the region.
+ * @param out
+ *      Receives the region on success.
+ * @return int
+ *      Returns zero on success, ERR_INVALID_ARGUMENT if alignment is not a
+ * power of two and ERR_POTENTIAL_BUFFER_OVERFLOW if the arena is exhausted.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int try_sc_arena_alloc(
+    sc_arena* arena,
+    size_t size,
+    size_t alignment,
+    sc_span* out) {
+  if (alignment & (alignment - 1)) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  const size_t padding = alignment > 1
+      ? (size_t)(-(uintptr_t)(arena->base + arena->used) & (alignment - 1))
+      : 0;
+  const size_t available = arena->size - arena->used;
+  if (padding > available || size > available - padding) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  *out = sc_span_make(arena->base + arena->used + padding, size);
+  arena->used += padding + size;
+  return 0;
+}
+
+/**
+ * Allocates size bytes aligned to alignment (a power of two, or 0 for no
+ * alignment) from arena. This version aborts the process if the arena is
+ * exhausted.
+ */
+static inline sc_span
+sc_arena_alloc(sc_arena* arena, size_t size, size_t alignment) {
+  sc_span out;
+  const int error = try_sc_arena_alloc(arena, size, alignment, &out);
+  if (error == ERR_INVALID_ARGUMENT) {
+    invalid_argument_error(__func__);
+  }
+  if (error != 0) {
+    buffer_overflow_error_with_size(
+        __func__, sc_arena_remaining(arena, alignment), size);
+  }
+  return out;
+}
+
+#if defined(SAFEC_GUARDED_ALLOC) || defined(SAFEC_PAGE_OPS)
+static inline size_t safec_page_size(void) {
+  return (size_t)sysconf(_SC_PAGESIZE);
+}
+#endif
+
+#ifdef SAFEC_GUARDED_ALLOC
+
+/*
+ * Guard-page allocation.
+ *
+ * Defining SAFEC_GUARDED_ALLOC provides sc_guarded_alloc(), which backs each
+ * buffer with its own mapping of whole pages between two PROT_NONE guard
+ * pages. The buffer is placed at the end of its pages, so a copy that runs
+ * past the end because of a wrong destination_size faults on the first byte
+ * out of bounds; underflows fault once they cross the front page boundary.
+ * It is meant to be left on for a slice of production traffic: freed regions
+ * of up to SAFEC_GUARDED_POOL_PAGES data pages are cached per page count and
+ * handed out again without any system call. Cached regions stay writable, so
+ * use after free is not detected.
+ */
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC guarded allocation requires a GCC-compatible compiler on POSIX"
+#endif
+
+#if defined(MAP_ANONYMOUS)
+#define SAFEC_MAP_ANONYMOUS MAP_ANONYMOUS
+#elif defined(MAP_ANON)
+#define SAFEC_MAP_ANONYMOUS MAP_ANON
+#else
+#error "SafeC guarded allocation requires MAP_ANONYMOUS (try _DEFAULT_SOURCE)"
+#endif
+
+#ifndef SAFEC_GUARDED_POOL_PAGES
+#define SAFEC_GUARDED_POOL_PAGES 16 // largest cached region, in data pages
+#endif
+#ifndef SAFEC_GUARDED_POOL_DEPTH
+#define SAFEC_GUARDED_POOL_DEPTH 16 // cached regions per page count
+#endif
+
+__attribute__((weak)) pthread_mutex_t safec_guarded_pool_lock =
+    PTHREAD_MUTEX_INITIALIZER;
+__attribute__((weak)) unsigned char* safec_guarded_pool
+    [SAFEC_GUARDED_POOL_PAGES][SAFEC_GUARDED_POOL_DEPTH];
+__attribute__((weak)) size_t safec_guarded_pool_size[SAFEC_GUARDED_POOL_PAGES];
+
+// Number of data pages backing a block of size bytes (at least one).
+static inline size_t safec_guarded_data_pages(size_t size, size_t page_size) {
+  return size == 0 ? 1 : size / page_size + (size % page_size != 0);
+}
+
+/**
+ * Allocates size bytes aligned to alignment (a power of two up to the page
+ * size, or 0 for no alignment) between two guard pages. With alignment 0 or
+ * 1 the block ends exactly at the trailing guard page. Release the block with
+ * sc_guarded_free().
+ *
+ * @param out
+ *      Receives the block on success and is left untouched otherwise.
+ * @return int
+ *      Returns zero on success, ERR_INVALID_ARGUMENT for an unsupported
+ * alignment, ERR_POTENTIAL_INTEGER_OVERFLOW if the mapping size does not fit
+ * in size_t and ERR_OUT_OF_MEMORY if the mapping failed or, with
+ * SAFEC_EXTENT_REGISTRY, the block could not be registered.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT static inline int
+try_sc_guarded_alloc(size_t size, size_t alignment, sc_span* out) {
+  const size_t page_size = safec_page_size();
+  if ((alignment & (alignment - 1)) != 0 || alignment > page_size) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  const size_t data_pages = safec_guarded_data_pages(size, page_size);
+  size_t map_size;
+  if (try_checked_mul_size(data_pages + 2, page_size, &map_size) != 0) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+
+  unsigned char* region = BAD_PTR;
+  if (data_pages <= SAFEC_GUARDED_POOL_PAGES) {
+    pthread_mutex_lock(&safec_guarded_pool_lock);
+    size_t* const cached = &safec_guarded_pool_size[data_pages - 1];
+    if (*cached != 0) {
+      region = safec_guarded_pool[data_pages - 1][--*cached];
+    }
+    pthread_mutex_unlock(&safec_guarded_pool_lock);
+  }
+  if (region == BAD_PTR) {
+    void* const mapping = mmap(
+        BAD_PTR,
+        map_size,
+        PROT_NONE,
+        MAP_PRIVATE | SAFEC_MAP_ANONYMOUS,
+        -1,
+        0);
+    if (mapping == MAP_FAILED) {
+      return ERR_OUT_OF_MEMORY;
+    }
+    region = (unsigned char*)mapping;
+    if (mprotect(
+            region + page_size,
+            data_pages * page_size,
+            PROT_READ | PROT_WRITE) != 0) {
+      munmap(region, map_size);
+      return ERR_OUT_OF_MEMORY;
+    }
+  }
+
+  // Round size up to the alignment; this cannot exceed the data pages since
+  // alignment divides the page size.
+  const size_t mask = alignment > 1 ? alignment - 1 : 0;
+  const size_t padded = (size + mask) & ~mask;
+  unsigned char* const data_end = region + (data_pages + 1) * page_size;
+  if (SAFEC_EXTENT_TRACK(data_end - padded, size) != 0) {
+    munmap(region, map_size);
+    return ERR_OUT_OF_MEMORY;
+  }
+  *out = sc_span_make(data_end - padded, size);
+  return 0;
+}
+
+/**
+ * Allocates size bytes between two guard pages. This version aborts the
+ * process if the allocation fails.
+ */
+static inline sc_span sc_guarded_alloc(size_t size, size_t alignment) {
+  sc_span out;
+  const int error = try_sc_guarded_alloc(size, alignment, &out);
+  if (error == ERR_INVALID_ARGUMENT) {
+    invalid_argument_error(__func__);
+  }
+  if (error == ERR_POTENTIAL_INTEGER_OVERFLOW) {
+    integer_overflow_error(__func__);
+  }
+  if (error != 0) {
+    out_of_memory_error(__func__, size);
+  }
+  return out;
+}
+
+/**
+ * Releases a block returned by sc_guarded_alloc(). block must be the span as
+ * it was returned. An empty span with a null pointer is ignored.
+ */
+static inline void sc_guarded_free(sc_span block) {
+  if (block.ptr == BAD_PTR) {
+    return;
+  }
+  SAFEC_EXTENT_UNTRACK(block.ptr);
+  const size_t page_size = safec_page_size();
+  const size_t data_pages = safec_guarded_data_pages(block.len, page_size);
+  // The block ends in the last data page, within alignment of its end.
+  const uintptr_t end = (uintptr_t)(block.ptr + block.len);
+  unsigned char* const data_end =
+      block.ptr + block.len + (page_size - end % page_size) % page_size;
+  unsigned char* const region = data_end - (data_pages + 1) * page_size;
+
+  if (data_pages <= SAFEC_GUARDED_POOL_PAGES) {
+    pthread_mutex_lock(&safec_guarded_pool_lock);
+    size_t* const cached = &safec_guarded_pool_size[data_pages - 1];
+    if (*cached < SAFEC_GUARDED_POOL_DEPTH) {
+      safec_guarded_pool[data_pages - 1][(*cached)++] = region;
+      pthread_mutex_unlock(&safec_guarded_pool_lock);
+      return;
+    }
+    pthread_mutex_unlock(&safec_guarded_pool_lock);
+  }
+  munmap(region, (data_pages + 2) * page_size);
+}
+
+/**
+ * Unmaps every region cached by sc_guarded_free().
+ */
+static inline void sc_guarded_pool_trim(void) {
+  const size_t page_size = safec_page_size();
+  pthread_mutex_lock(&safec_guarded_pool_lock);
+  for (size_t pages = 1; pages <= SAFEC_GUARDED_POOL_PAGES; ++pages) {
+    size_t* const cached = &safec_guarded_pool_size[pages - 1];
+    while (*cached != 0) {
+      munmap(
+          safec_guarded_pool[pages - 1][--*cached], (pages + 2) * page_size);
+    }
+  }
+  pthread_mutex_unlock(&safec_guarded_pool_lock);
+}
+
+#endif // SAFEC_GUARDED_ALLOC
+
+#ifdef SAFEC_PAGE_OPS
+
+/*
+ * Page-level operations.
+ *
+ * Defining SAFEC_PAGE_OPS provides checked_memzero_large(), which clears
+ * large buffers by handing their whole pages back to the kernel instead of
+ * writing every byte, and checked_memmove_pages(), which moves large
+ * page-aligned regions by remapping their pages. The ranges must lie in
+ * private anonymous memory (heap and malloc()ed blocks, MAP_PRIVATE |
+ * MAP_ANONYMOUS mappings): for file or shared mappings the kernel does not
+ * provide zero pages, and the contents would silently change to something
+ * else. Pages given back are faulted in again as zero pages on the next
+ * access, so clearing also releases the resident memory of the buffer. Page
+ * moves need MREMAP_DONTUNMAP, which glibc declares with _GNU_SOURCE; without
+ * it checked_memmove_pages() always copies.
+ */
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC page operations require a GCC-compatible compiler on POSIX"
+#endif
+
+#if defined(__linux__) && !defined(MADV_DONTNEED)
+#error "SafeC page operations require MADV_DONTNEED (try _DEFAULT_SOURCE)"
+#endif
+
+// Smallest range that is cleared with madvise(); below it, the system call
+// and the page faults that follow cost more than storing zeros.
+#ifndef SAFEC_MEMZERO_MADVISE_THRESHOLD
+#define SAFEC_MEMZERO_MADVISE_THRESHOLD ((size_t)1 << 20)
+#endif
+
+/*
+ * Zeros count bytes at destination. On Linux, the whole pages of a large
+ * range are dropped with madvise(MADV_DONTNEED), which makes them read back as
+ * zeros, and only the partial pages at either end are stored to. Elsewhere,
+ * or if madvise() fails (e.g. on locked pages), every byte is stored. Returns
+ * destination.
+ */
+static inline void* safec_memzero_large(
+    unsigned char* destination,
+    size_t count) {
+#if defined(__linux__)
+  if (count >= SAFEC_MEMZERO_MADVISE_THRESHOLD) {
+    const uintptr_t page_mask = (uintptr_t)safec_page_size() - 1;
+    const uintptr_t start = (uintptr_t)destination;
+    const uintptr_t first = (start + page_mask) & ~page_mask;
+    const uintptr_t last = (start + count) & ~page_mask;
+    if (first < last &&
+        madvise((void*)first, last - first, MADV_DONTNEED) == 0) {
+      memset(destination, 0, first - start);
+      memset((unsigned char*)last, 0, start + count - last);
+      return destination;
+    }
+  }
+#endif
+  memset(destination, 0, count);
+  return destination;
+}
+
+/**
+ * Zeros a large buffer in private anonymous memory, returning its whole pages
+ * to the kernel instead of storing to them. This version aborts the process
+ * if there's a possibility of writing out-of-bounds.
+ *
+ * @param destination
+ *      Pointer to the destination to clear. The range must lie in private
+ * anonymous memory; see SAFEC_PAGE_OPS.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param count
+ *      Number of bytes to clear.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memzero_large(
+    void* destination,
+    size_t destination_size,
+    size_t count) {
+  SAFEC_OP(
+      checked_memzero_large, destination, BAD_PTR, count, destination_size);
+  if (count > destination_size) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+
+  return SAFEC_OP_CALL(
+      safec_memzero_large((unsigned char*)destination, count));
+}
+
+/**
+ * Zeros a large buffer in private anonymous memory, returning its whole pages
+ * to the kernel instead of storing to them. This version returns an error
+ * code if there's a possibility of writing out-of-bounds. Error handling is
+ * mandatory. Note that using this function without error handling does not
+ * guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination to clear. The range must lie in private
+ * anonymous memory; see SAFEC_PAGE_OPS.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param count
+ *      Number of bytes to clear.
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memzero_large(
+    void* destination,
+    size_t destination_size,
+    size_t count) {
+  SAFEC_OP(
+      try_checked_memzero_large,
+      destination,
+      BAD_PTR,
+      count,
+      destination_size);
+  if (count > destination_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  SAFEC_OP_CALL(safec_memzero_large((unsigned char*)destination, count));
+  return 0;
+}
+
+// Smallest move that is done with mremap(). Moving page table entries costs a
+// few microseconds plus freeing the destination's old pages; copies of up to
+// about 512 KiB stay in cache and are faster, and at 1 MiB the two are even.
+#ifndef SAFEC_MEMMOVE_PAGES_THRESHOLD
+#define SAFEC_MEMMOVE_PAGES_THRESHOLD ((size_t)1 << 20)
+#endif
+
+/*
+ * Moves count bytes from source to destination. On Linux, when both are page
+ * aligned and the two ranges do not overlap at all, the whole pages are moved
+ * with mremap(MREMAP_DONTUNMAP), which transfers the page table entries and
+ * leaves the source mapped with zero pages; the partial page at the end is
+ * copied. Comparing only the whole pages is not enough: the source tail could
+ * then lie in a destination page that the remap has just replaced.
+ * Otherwise, or if mremap() fails (e.g. across mappings, or on kernels before
+ * 5.7), the bytes are moved with memmove(). Returns destination.
+ */
+static inline void* safec_memmove_pages(
+    unsigned char* destination,
+    unsigned char* source,
+    size_t count) {
+#if defined(__linux__) && defined(MREMAP_DONTUNMAP)
+  if (count >= SAFEC_MEMMOVE_PAGES_THRESHOLD) {
+    const uintptr_t page_mask = (uintptr_t)safec_page_size() - 1;
+    const uintptr_t to = (uintptr_t)destination;
+    const uintptr_t from = (uintptr_t)source;
+    const size_t pages = count & ~page_mask;
+    if (((to | from) & page_mask) == 0 &&
+        (to + count <= from || from + count <= to) &&
+        mremap(
+            source,
+            pages,
+            pages,
+            MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP,
+            destination) != MAP_FAILED) {
+      memmove(destination + pages, source + pages, count - pages);
+      return destination;
+    }
+  }
+#endif
+  return memmove(destination, source, count);
+}
+
+/**
+ * Bounds checking (i.e. both source and destination) move of a large
+ * page-aligned region, remapping whole pages instead of copying them where
+ * possible. After the move the source is still mapped but its contents are
+ * unspecified: either unchanged or zero. The regions may overlap. This
+ * version aborts the process if there's a possibility of buffer overflow.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be moved. Must lie
+ * in private anonymous memory; its pages may be replaced.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be moved. Must lie in private anonymous
+ * memory.
+ * @param source_size
+ *      Max number of bytes to move from the source (typically the size of the
+ * source buffer).
+ * @param count
+ *      Number of bytes to move.
+ * @return void *
+ *      Pointer to the destination.
+ */
+SAFEC_API void* checked_memmove_pages(
+    void* destination,
+    size_t destination_size,
+    void* source,
+    size_t source_size,
+    size_t count) {
+  SAFEC_OP(
+      checked_memmove_pages,
+      destination,
+      source,
+      count,
+      destination_size < source_size ? destination_size : source_size);
+  if (destination_size < count) {
+    buffer_overflow_error_with_size(__func__, destination_size, count);
+  }
+  if (source_size < count) {
+    buffer_oob_read_error(__func__);
+  }
+  if (source == BAD_PTR || destination == BAD_PTR) {
+    null_pointer_error(__func__);
+  }
+
+  return SAFEC_OP_CALL(safec_memmove_pages(
+      (unsigned char*)destination, (unsigned char*)source, count));
+}
+
+/**
+ * Bounds checking (i.e. both source and destination) move of a large
+ * page-aligned region, remapping whole pages instead of copying them where
+ * possible. After the move the source is still mapped but its contents are
+ * unspecified: either unchanged or zero. The regions may overlap. This
+ * version returns an error code if there's a possibility of buffer overflow.
+ * Error handling is mandatory. Note that using this function without error
+ * handling does not guarantee security.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be moved. Must lie
+ * in private anonymous memory; its pages may be replaced.
+ * @param destination_size
+ *      Max number of bytes to modify in the destination (typically the size of
+ * the destination buffer).
+ * @param source
+ *      Pointer to the source of data to be moved. Must lie in private anonymous
+ * memory.
+ * @param source_size
+ *      Max number of bytes to move from the source (typically the size of the
+ * source buffer).
+ * @param count
+ *      Number of bytes to move.
+ * @return int
+ *      Returns zero on success and a safec_error value on error.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int try_checked_memmove_pages(
+    void* destination,
+    size_t destination_size,
+    void* source,
+    size_t source_size,
+    size_t count) {
+  SAFEC_OP(
+      try_checked_memmove_pages,
+      destination,
+      source,
+      count,
+      destination_size < source_size ? destination_size : source_size);
+  if (destination_size < count || source_size < count) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+
+  SAFEC_OP_CALL(safec_memmove_pages(
+      (unsigned char*)destination, (unsigned char*)source, count));
+  return 0;
+}
+
+#endif // SAFEC_PAGE_OPS
+
+#ifdef SAFEC_FD_COPY
+
+/*
+ * File range copies.
+ *
+ * Defining SAFEC_FD_COPY provides checked_copy_fd_range(), which copies a
+ * byte range of a regular file to another descriptor without passing it
+ * through a user space buffer when the kernel can move it directly. On Linux
+ * it tries copy_file_range(), which can share extents on copy-on-write
+ * filesystems, then sendfile(), then splice() when the output is a pipe, and
+ * finally a pread()/write() loop; each method continues where the previous
+ * one stopped. Other systems use the loop only. Both descriptors must be in
+ * blocking mode.
+ */
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC file range copies require a GCC-compatible compiler on POSIX"
+#endif
+
+#if defined(__linux__) && !defined(SPLICE_F_MOVE)
+#error "SafeC file range copies require copy_file_range (try _GNU_SOURCE)"
+#endif
+
+// Size of the buffer used by the pread()/write() fallback.
+#ifndef SAFEC_FD_COPY_BUFFER_SIZE
+#define SAFEC_FD_COPY_BUFFER_SIZE ((size_t)64 << 10)
+#endif
+
+/*
+ * Copies len bytes at offset in in_fd to the current position of out_fd. The
+ * in-kernel methods give up on any error or early end of file, and the
+ * pread()/write() loop, which is the one that reports errors, picks up the
+ * rest. Returns zero, ERR_IO if reading or writing failed or the file ended
+ * early, or ERR_OUT_OF_MEMORY if the fallback buffer could not be allocated.
+ */
+static inline int
+safec_copy_fd_range(int out_fd, int in_fd, off_t offset, size_t len) {
+  size_t done = 0;
+#if defined(__linux__)
+  while (done < len) {
+    loff_t from = offset + (off_t)done;
+    const ssize_t n =
+        copy_file_range(in_fd, &from, out_fd, NULL, len - done, 0);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n == 0 || errno != EINTR) {
+      break;
+    }
+  }
+  while (done < len) {
+    off_t from = offset + (off_t)done;
+    const ssize_t n = sendfile(out_fd, in_fd, &from, len - done);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n == 0 || errno != EINTR) {
+      break;
+    }
+  }
+  struct stat out_stat;
+  if (done < len && fstat(out_fd, &out_stat) == 0 &&
+      S_ISFIFO(out_stat.st_mode)) {
+    while (done < len) {
+      loff_t from = offset + (off_t)done;
+      const ssize_t n =
+          splice(in_fd, &from, out_fd, NULL, len - done, SPLICE_F_MOVE);
+      if (n > 0) {
+        done += (size_t)n;
+      } else if (n == 0 || errno != EINTR) {
+        break;
+      }
+    }
+  }
+#endif
+  if (done == len) {
+    return 0;
+  }
+
+  const size_t buffer_size = len - done < SAFEC_FD_COPY_BUFFER_SIZE
+      ? len - done
+      : SAFEC_FD_COPY_BUFFER_SIZE;
+  unsigned char* const buffer = (unsigned char*)malloc(buffer_size);
+  if (buffer == NULL) {
+    return ERR_OUT_OF_MEMORY;
+  }
+  int error = 0;
+  while (done < len && error == 0) {
+    const size_t chunk =
+        len - done < buffer_size ? len - done : buffer_size;
+    const ssize_t got = pread(in_fd, buffer, chunk, offset + (off_t)done);
+    if (got <= 0) {
+      error = got < 0 && errno == EINTR ? 0 : ERR_IO;
+      continue;
+    }
+    size_t put = 0;
+    while (put < (size_t)got) {
+      const ssize_t n = write(out_fd, buffer + put, (size_t)got - put);
+      if (n > 0) {
+        put += (size_t)n;
+      } else if (n == 0 || errno != EINTR) {
+        error = ERR_IO;
+        break;
+      }
+    }
+    done += put;
+  }
+  free(buffer);
+  return error;
+}
+
+/*
+ * Checks the range against the size of in_fd. Returns zero,
+ * ERR_INVALID_ARGUMENT for a negative offset or an in_fd that is not a
+ * regular file, ERR_POTENTIAL_INTEGER_OVERFLOW if offset + len overflows and
+ * ERR_POTENTIAL_BUFFER_OVERFLOW if the range ends past the end of the file.
+ */
+static inline int safec_check_fd_range(int in_fd, off_t offset, size_t len) {
+  struct stat in_stat;
+  if (offset < 0 || fstat(in_fd, &in_stat) != 0 ||
+      !S_ISREG(in_stat.st_mode)) {
+    return ERR_INVALID_ARGUMENT;
+  }
+  if ((uint64_t)len > UINT64_MAX - (uint64_t)offset) {
+    return ERR_POTENTIAL_INTEGER_OVERFLOW;
+  }
+  if ((uint64_t)offset + len > (uint64_t)in_stat.st_size) {
+    return ERR_POTENTIAL_BUFFER_OVERFLOW;
+  }
+  return 0;
+}
+
+/**
+ * Copies a byte range of a regular file to the current position of another
+ * file descriptor, inside the kernel when possible. This version aborts the
+ * process if the range does not lie within the input file, or if the copy
+ * fails.
+ *
+ * @param out_fd
+ *      Descriptor to write to, at (and advancing) its current position.
+ * @param in_fd
+ *      Descriptor of the regular file to read from. Its position is not
+ * changed.
+ * @param offset
+ *      Offset of the range in the input file.
+ * @param len
+ *      Number of bytes to copy.
+ */
+SAFEC_API void
+checked_copy_fd_range(int out_fd, int in_fd, off_t offset, size_t len) {
+  SAFEC_OP(checked_copy_fd_range, BAD_PTR, BAD_PTR, len, len);
+  switch (safec_check_fd_range(in_fd, offset, len)) {
+    case 0:
+      break;
+    case ERR_POTENTIAL_INTEGER_OVERFLOW:
+      integer_overflow_error(__func__);
+    case ERR_POTENTIAL_BUFFER_OVERFLOW:
+      buffer_oob_read_error(__func__);
+    default:
+      invalid_argument_error(__func__);
+  }
+
+  const int error =
+      SAFEC_OP_CALL(safec_copy_fd_range(out_fd, in_fd, offset, len));
+  if (error == ERR_OUT_OF_MEMORY) {
+    out_of_memory_error(__func__, SAFEC_FD_COPY_BUFFER_SIZE);
+  }
+  if (error != 0) {
+    io_error(__func__);
+  }
+}
+
+/**
+ * Copies a byte range of a regular file to the current position of another
+ * file descriptor, inside the kernel when possible. This version returns an
+ * error code if the range does not lie within the input file, or if the copy
+ * fails. Error handling is mandatory. Note that using this function without
+ * error handling does not guarantee security.
+ *
+ * @param out_fd
+ *      Descriptor to write to, at (and advancing) its current position.
+ * @param in_fd
+ *      Descriptor of the regular file to read from. Its position is not
+ * changed.
+ * @param offset
+ *      Offset of the range in the input file.
+ * @param len
+ *      Number of bytes to copy.
+ * @return int
+ *      Returns zero on success and a safec_error value on error. On ERR_IO,
+ * an unspecified part of the range may have been written.
+ */
+SECURE_LIB_WARN_UNUSED_RESULT SAFEC_API int
+try_checked_copy_fd_range(int out_fd, int in_fd, off_t offset, size_t len) {
+  SAFEC_OP(try_checked_copy_fd_range, BAD_PTR, BAD_PTR, len, len);
+  const int error = safec_check_fd_range(in_fd, offset, len);
+  if (error != 0) {
+    return error;
+  }
+
+  return SAFEC_OP_CALL(safec_copy_fd_range(out_fd, in_fd, offset, len));
+}
+
+#endif // SAFEC_FD_COPY
+
+#if defined(SAFEC_TRACE) || defined(SAFEC_TRACE_REPLAY)
+
+#if defined(_WIN32) || defined(_WIN64) || defined(NO_ATTRIBUTE_EXTENSION)
+#error "SafeC trace replay requires a GCC-compatible compiler on POSIX"
+#endif
+
+struct safec_trace_record {
+  unsigned api;
+  unsigned destination_misalignment;
+  unsigned source_misalignment;
+  size_t count;
+  size_t limit;
+};
+
+// Candidate copy kernel with the signature of memcpy.
+typedef void* (*safec_copy_kernel)(
+    void* destination,
+    const void* source,
+    size_t count);
+
+static inline const unsigned char* safec_trace_get_varint(
+    const unsigned char* in,
+    const unsigned char* end,
+    uint64_t* value) {
+  *value = 0;
+  for (unsigned shift = 0; in != end && shift < 64; shift += 7) {
+    const unsigned char byte = *in++;
+    *value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return in;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Reads a trace file written in SAFEC_TRACE mode.
+ *
+ * @param path
+ *      Path of the trace file.
+ * @param records
+ *      Receives an array of decoded records to be released with free().
+ * @param count
+ *      Receives the number of decoded records.
+ * @return int
+ *      Returns zero on success and non-zero value on error.
+ */
+static inline int safec_trace_load(
+    const char* path,
+    struct safec_trace_record** records,
+    size_t* count) {
+  *records = NULL;
+  *count = 0;
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    return -1;
+  }
+  size_t size = 0;
+  size_t capacity = 0;
+  unsigned char* data = NULL;
+  int failed = 0;
+  for (;;) {
+    if (size == capacity) {
+      capacity = capacity ? capacity * 2 : 65536;
+      unsigned char* grown = (unsigned char*)realloc(data, capacity);
+      if (grown == NULL) {
+        failed = 1;
+        break;
+      }
+      data = grown;
+    }
+    const size_t read = fread(data + size, 1, capacity - size, in);
+    if (read == 0) {
+      break;
+    }
+    size += read;
+  }
+  failed |= ferror(in);
+  fclose(in);
+  if (failed || size < 8 || memcmp(data, SAFEC_TRACE_MAGIC, 8) != 0) {
+    free(data);
+    return -1;
+  }
+
+  // Every record takes at least five bytes.
+  struct safec_trace_record* out = (struct safec_trace_record*)malloc(
+      ((size - 8) / 5 + 1) * sizeof(*out));
+  if (out == NULL) {
+    free(data);
+    return -1;
+  }
+  size_t used = 0;
+  const unsigned char* cursor = data + 8;
+  const unsigned char* const end = data + size;
+  while (cursor != NULL && end - cursor >= 5) {
+    struct safec_trace_record* record = &out[used];
+    uint64_t value = 0;
+    record->api = cursor[0];
+    record->destination_misalignment = cursor[1] % SAFEC_TRACE_ALIGNMENT;
+    record->source_misalignment = cursor[2] % SAFEC_TRACE_ALIGNMENT;
+    cursor = safec_trace_get_varint(cursor + 3, end, &value);
+    record->count = (size_t)value;
+    if (cursor != NULL) {
+      cursor = safec_trace_get_varint(cursor, end, &value);
+      record->limit = (size_t)value;
+    }
+    if (cursor != NULL) {
+      ++used;
+    }
+  }
+  free(data);
+  *records = out;
+  *count = used;
+  return 0;
+}
+
+// Returns whether a call recorded with a count above its limit truncates
+// (the _clamp functions) or returns an error (the try_ functions) instead of
+// aborting, so that replaying it is meaningful.
+static inline int safec_trace_replays_overflow(unsigned api) {
+  return api == safec_api_checked_memcpy_clamp ||
+      api == safec_api_checked_strcat_clamp ||
+      strncmp(safec_api_name(api), "try_", 4) == 0;
+}
+
+/**
+ * Replays a recorded workload and returns the elapsed wall time. Every record
+ * is driven through the checked wrapper it was recorded from or, when kernel
+ * is not NULL, through kernel with the number of bytes the wrapper copied,
+ * using buffers with the recorded misalignments. Records whose count exceeded
+ * their limit are skipped if their wrapper would abort; truncating and failing
+ * calls are replayed as they happened. String operations are replayed with an
+ * empty destination string and a source string of the recorded length.
+ *
+ * @param records
+ *      Records returned by safec_trace_load().
+ * @param count
+ *      Number of records.
+ * @param kernel
+ *      Candidate copy kernel, or NULL to use the checked wrappers.
+ * @return uint64_t
+ *      Elapsed nanoseconds, or UINT64_MAX if buffers could not be allocated.
+ */
+static inline uint64_t safec_trace_replay(
+    const struct safec_trace_record* records,
+    size_t count,
+    safec_copy_kernel kernel) {
+  size_t max_size = 1;
+  for (size_t i = 0; i < count; ++i) {
+    size_t size = records[i].limit;
+    if (records[i].count > size) {
+      if (!safec_trace_replays_overflow(records[i].api)) {
+        continue;
+      }
+      size = records[i].count;
+    }
+    if (size > max_size) {
+      max_size = size;
+    }
+  }
+  if (max_size > SIZE_MAX / 2 - 2 * SAFEC_TRACE_ALIGNMENT) {
+    return UINT64_MAX;
+  }
+  const size_t buffer_size = max_size + 2 * SAFEC_TRACE_ALIGNMENT;
+  char* const destination_block = (char*)calloc(1, buffer_size);
+  char* const source_block = (char*)malloc(buffer_size);
+  if (destination_block == NULL || source_block == NULL) {
+    free(destination_block);
+    free(source_block);
+    return UINT64_MAX;
+  }
+  memset(source_block, 'a', buffer_size);
+  char* const destination_base = destination_block + SAFEC_TRACE_ALIGNMENT -
+      (uintptr_t)destination_block % SAFEC_TRACE_ALIGNMENT;
+  char* const source_base = source_block + SAFEC_TRACE_ALIGNMENT -
+      (uintptr_t)source_block % SAFEC_TRACE_ALIGNMENT;
+
+#ifdef SAFEC_TRACE
+  const int suppressed = safec_trace_tls_suppressed;
+  safec_trace_tls_suppressed = 1;
+#endif
+  int sink = 0;
+  int result = 0;
+  uint32_t crc = 0;
+  const uint64_t start = safec_now_ns();
+  for (size_t i = 0; i < count; ++i) {
+    const struct safec_trace_record* record = &records[i];
+    const size_t n = record->count;
+    const size_t limit = record->limit;
+    char* const destination =
+        destination_base + record->destination_misalignment;
+    char* const source = source_base + record->source_misalignment;
+    if (n > limit && !safec_trace_replays_overflow(record->api)) {
+      continue;
+    }
+    if (kernel != NULL) {
+      if (n <= limit) {
+        kernel(destination, source, n);
+      } else if (record->api == safec_api_checked_memcpy_clamp ||
+                 record->api == safec_api_checked_strcat_clamp) {
+        kernel(destination, source, limit);
+      }
+    } else {
+      switch (record->api) {
+        // Replay buffers are not registered; the _auto wrappers are replayed
+        // with their recorded destination size.
+        case safec_api_checked_memcpy:
+        case safec_api_checked_memcpy_auto:
+          checked_memcpy(destination, limit, source, n);
+          break;
+        case safec_api_checked_memcpy_offset:
+          checked_memcpy_offset(destination, limit, 0, source, n);
+          break;
+        case safec_api_try_checked_memcpy_offset:
+          sink |= try_checked_memcpy_offset(destination, limit, 0, source, n);
+          break;
+        case safec_api_checked_memcpy_robust:
+          checked_memcpy_robust(destination, limit, source, limit, n);
+          break;
+        case safec_api_try_checked_memcpy:
+        case safec_api_try_checked_memcpy_auto:
+          sink |= try_checked_memcpy(destination, limit, source, n);
+          break;
+        case safec_api_try_checked_memcpy_robust:
+          sink |=
+              try_checked_memcpy_robust(destination, limit, source, limit, n);
+          break;
+        case safec_api_checked_strcat:
+        case safec_api_try_checked_strcat:
+        case safec_api_checked_strcat_clamp:
+          if (n == 0) {
+            break;
+          }
+          destination[0] = '\0';
+          source[n - 1] = '\0';
+          if (record->api == safec_api_checked_strcat) {
+            checked_strcat(destination, limit, source);
+          } else if (record->api == safec_api_try_checked_strcat) {
+            sink |= try_checked_strcat(destination, limit, source);
+          } else {
+            sink |= (int)checked_strcat_clamp(destination, limit, source, NULL);
+          }
+          source[n - 1] = 'a';
+          break;
+        case safec_api_checked_memcpy_clamp:
+          sink |=
+              (int)checked_memcpy_clamp(destination, limit, source, n, NULL);
+          break;
+        case safec_api_checked_memcpy_elems:
+        case safec_api_try_checked_memcpy_elems: {
+          // Only byte counts are traced; replay with the widest element
+          // size that divides both.
+          size_t elem_size = 32;
+          while (elem_size > 1 && ((n | limit) & (elem_size - 1)) != 0) {
+            elem_size /= 2;
+          }
+          const size_t elems = n / elem_size;
+          const size_t limit_elems = limit / elem_size;
+          if (record->api == safec_api_checked_memcpy_elems) {
+            checked_memcpy_elems(
+                destination,
+                limit_elems,
+                source,
+                limit_elems,
+                elems,
+                elem_size);
+          } else {
+            sink |= try_checked_memcpy_elems(
+                destination,
+                limit_elems,
+                source,
+                limit_elems,
+                elems,
+                elem_size);
+          }
+          break;
+        }
+        case safec_api_checked_memcpy_bswap16:
+          checked_memcpy_bswap16(destination, limit, source, n / 2);
+          break;
+        case safec_api_checked_memcpy_bswap32:
+          checked_memcpy_bswap32(destination, limit, source, n / 4);
+          break;
+        case safec_api_checked_memcpy_bswap64:
+          checked_memcpy_bswap64(destination, limit, source, n / 8);
+          break;
+        case safec_api_try_checked_memcpy_bswap16:
+          sink |= try_checked_memcpy_bswap16(destination, limit, source, n / 2);
+          break;
+        case safec_api_try_checked_memcpy_bswap32:
+          sink |= try_checked_memcpy_bswap32(destination, limit, source, n / 4);
+          break;
+        case safec_api_try_checked_memcpy_bswap64:
+          sink |= try_checked_memcpy_bswap64(destination, limit, source, n / 8);
+          break;
+        case safec_api_checked_memcpy_crc32c:
+          checked_memcpy_crc32c(destination, limit, source, n, &crc);
+          break;
+        case safec_api_try_checked_memcpy_crc32c:
+          sink |=
+              try_checked_memcpy_crc32c(destination, limit, source, n, &crc);
+          break;
+        // Only the destination extent is traced; replay it as a single row.
+        case safec_api_checked_memcpy_2d:
+          checked_memcpy_2d(destination, limit, n, source, limit, n, n, 1);
+          break;
+        case safec_api_try_checked_memcpy_2d:
+          sink |= try_checked_memcpy_2d(
+              destination, limit, n, source, limit, n, n, 1);
+          break;
+        case safec_api_checked_memcmp:
+          sink |= checked_memcmp(destination, limit, source, limit, n);
+          break;
+        case safec_api_try_checked_memcmp:
+          sink |= try_checked_memcmp(
+              destination, limit, source, limit, n, &result);
+          break;
+        case safec_api_checked_strncmp:
+          sink |= checked_strncmp(destination, limit, source, limit, n);
+          break;
+        case safec_api_try_checked_strncmp:
+          sink |= try_checked_strncmp(
+              destination, limit, source, limit, n, &result);
+          break;
+        case safec_api_checked_memset:
+          checked_memset(destination, limit, 0, n);
+          break;
+        case safec_api_try_checked_memset:
+          sink |= try_checked_memset(destination, limit, 0, n);
+          break;
+        case safec_api_checked_memset16:
+          checked_memset16(destination, limit, 0xFFFF, n / 2);
+          break;
+        case safec_api_checked_memset32:
+          checked_memset32(destination, limit, 0xFFFFFFFF, n / 4);
+          break;
+        case safec_api_checked_memset64:
+          checked_memset64(destination, limit, UINT64_MAX, n / 8);
+          break;
+        case safec_api_try_checked_memset16:
+          sink |= try_checked_memset16(destination, limit, 0xFFFF, n / 2);
+          break;
+        case safec_api_try_checked_memset32:
+          sink |= try_checked_memset32(destination, limit, 0xFFFFFFFF, n / 4);
+          break;
+        case safec_api_try_checked_memset64:
+          sink |= try_checked_memset64(destination, limit, UINT64_MAX, n / 8);
+          break;
+        // The pattern itself is not traced; replay with a 3-byte one, which
+        // takes the slower non-vector path.
+        case safec_api_checked_memset_pattern:
+          checked_memset_pattern(destination, limit, "abc", 3, n);
+          break;
+        case safec_api_try_checked_memset_pattern:
+          sink |= try_checked_memset_pattern(destination, limit, "abc", 3, n);
+          break;
+#ifdef SAFEC_PAGE_OPS
+        // The replay buffers come from malloc(), so they are private anonymous
+        // memory.
+        case safec_api_checked_memzero_large:
+          checked_memzero_large(destination, limit, n);
+          break;
+        case safec_api_try_checked_memzero_large:
+          sink |= try_checked_memzero_large(destination, limit, n);
+          break;
+        case safec_api_checked_memmove_pages:
+          checked_memmove_pages(destination, limit, source, limit, n);
+          break;
+        case safec_api_try_checked_memmove_pages:
+          sink |=
+              try_checked_memmove_pages(destination, limit, source, limit, n);
+          break;
+#endif
+        // File range copies have no buffers to replay.
+        case safec_api_checked_copy_fd_range:
+        case safec_api_try_checked_copy_fd_range:
+          break;
+        default:
+          break;
+      }
+    }
+    // Keep the compiler from discarding the stores into the scratch buffers.
+    __asm__ __volatile__(
+        ""
+        :
+        : "r"(destination), "r"(sink), "r"(result), "r"(crc)
+        : "memory");
+  }
+  const uint64_t elapsed = safec_now_ns() - start;
+#ifdef SAFEC_TRACE
+  safec_trace_tls_suppressed = suppressed;
+#endif
+
+  free(destination_block);
+  free(source_block);
+  return elapsed;
+}
+
+#endif // SAFEC_TRACE || SAFEC_TRACE_REPLAY
+
+#ifdef __cplusplus
+} // extern "C"
+
+/*
+ * C++ layer (C++17 and later).
+ *
+ * The safec namespace overloads the checked wrappers for buffers whose size
+ * the compiler can deduce: built-in arrays, std::array, std::span and (as a
+ * read-only source) std::string_view. The C functions are brought into the
+ * namespace as well, so safec::checked_memcpy names the whole overload set.
+ * When the extents of both buffers are known at compile time the bounds are
+ * checked with static_assert and no runtime check is emitted; otherwise the
+ * call forwards to the C function with the deduced sizes.
+ */
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#if defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#ifdef __cpp_lib_expected
+#include <expected>
+#endif
+
+namespace safec {
+
+using ::checked_memcmp;
+using ::checked_memcpy;
+using ::checked_memcpy_elems;
+using ::checked_memcpy_offset;
+using ::checked_memset;
+using ::checked_strcat;
+using ::checked_strncmp;
+
+namespace detail {
+
+inline constexpr std::size_t dynamic_size = static_cast<std::size_t>(-1);
+
+// Byte extent of the buffer types the C++ layer accepts.
+template <typename B>
+struct buffer_extent {
+  static constexpr bool is_buffer = false;
+};
+
+template <typename T, std::size_t N>
+struct buffer_extent<T[N]> {
+  static constexpr bool is_buffer = true;
+  static constexpr std::size_t size = sizeof(T) * N;
+};
+
+template <typename T, std::size_t N>
+struct buffer_extent<std::array<T, N>> {
+  static constexpr bool is_buffer = true;
+  static constexpr std::size_t size = sizeof(T) * N;
+};
+
+#ifdef __cpp_lib_span
+template <typename T, std::size_t Extent>
+struct buffer_extent<std::span<T, Extent>> {
+  static constexpr bool is_buffer = true;
+  static constexpr std::size_t size =
+      Extent == std::dynamic_extent ? dynamic_size : sizeof(T) * Extent;
+};
+#endif
+
+template <typename CharT, typename Traits>
+struct buffer_extent<std::basic_string_view<CharT, Traits>> {
+  static constexpr bool is_buffer = true;
+  static constexpr std::size_t size = dynamic_size;
+};
+
+template <typename B>
+using extent_of = buffer_extent<std::remove_cv_t<std::remove_reference_t<B>>>;
+
+template <typename B, bool = extent_of<B>::is_buffer>
+struct buffer_element {};
+
+template <typename B>
+struct buffer_element<B, true> {
+  using type = std::remove_pointer_t<decltype(std::data(
+      std::declval<std::remove_reference_t<B>&>()))>;
+};
+
+template <typename B, typename = void>
+struct is_buffer : std::false_type {};
+
+template <typename B>
+struct is_buffer<B, std::void_t<typename buffer_element<B>::type>>
+    : std::bool_constant<std::is_trivially_copyable_v<
+          std::remove_cv_t<typename buffer_element<B>::type>>> {};
+
+template <typename B, typename = void>
+struct is_writable_buffer : std::false_type {};
+
+template <typename B>
+struct is_writable_buffer<B, std::enable_if_t<is_buffer<B>::value>>
+    : std::bool_constant<!std::is_const_v<typename buffer_element<B>::type>> {
+};
+
+template <typename B, typename = void>
+struct is_char_buffer : std::false_type {};
+
+template <typename B>
+struct is_char_buffer<B, std::enable_if_t<is_buffer<B>::value>>
+    : std::is_same<std::remove_cv_t<typename buffer_element<B>::type>, char> {
+};
+
+template <typename B>
+inline constexpr bool is_buffer_v = is_buffer<B>::value;
+
+template <typename B>
+inline constexpr bool is_writable_buffer_v = is_writable_buffer<B>::value;
+
+template <typename B>
+inline constexpr bool is_char_buffer_v = is_char_buffer<B>::value;
+
+template <typename B>
+inline constexpr bool has_static_size_v =
+    is_buffer_v<B> && extent_of<B>::size != dynamic_size;
+
+template <typename B>
+constexpr std::size_t buffer_size(const B& buffer) noexcept {
+  if constexpr (has_static_size_v<B>) {
+    (void)buffer;
+    return extent_of<B>::size;
+  } else {
+    return std::size(buffer) * sizeof(*std::data(buffer));
+  }
+}
+
+} // namespace detail
+
+/**
+ * Copies the whole of source into destination. The bounds check is a
+ * static_assert when both sizes are known at compile time.
+ */
+template <
+    typename D,
+    typename S,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_buffer_v<S>,
+        int> = 0>
+inline void* checked_memcpy(D&& destination, const S& source) {
+  if constexpr (detail::has_static_size_v<D> && detail::has_static_size_v<S>) {
+    static_assert(
+        detail::extent_of<S>::size <= detail::extent_of<D>::size,
+        "checked_memcpy: source is larger than destination");
+    return std::memcpy(
+        std::data(destination), std::data(source), detail::extent_of<S>::size);
+  } else {
+    return ::checked_memcpy(
+        std::data(destination),
+        detail::buffer_size(destination),
+        std::data(source),
+        detail::buffer_size(source));
+  }
+}
+
+/**
+ * Copies Count bytes from source into destination, checking Count against
+ * the static extents at compile time and against dynamic ones at run time.
+ */
+template <
+    std::size_t Count,
+    typename D,
+    typename S,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_buffer_v<S>,
+        int> = 0>
+inline void* checked_memcpy(D&& destination, const S& source) {
+  if constexpr (detail::has_static_size_v<D> && detail::has_static_size_v<S>) {
+    static_assert(
+        Count <= detail::extent_of<D>::size,
+        "checked_memcpy: count is larger than destination");
+    static_assert(
+        Count <= detail::extent_of<S>::size,
+        "checked_memcpy: count is larger than source");
+    return std::memcpy(std::data(destination), std::data(source), Count);
+  } else {
+    return ::checked_memcpy_robust(
+        std::data(destination),
+        detail::buffer_size(destination),
+        std::data(source),
+        detail::buffer_size(source),
+        Count);
+  }
+}
+
+/**
+ * Copies Count bytes from a raw source pointer into destination.
+ */
+template <
+    std::size_t Count,
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+inline void* checked_memcpy(D&& destination, const void* source) {
+  if constexpr (detail::has_static_size_v<D>) {
+    static_assert(
+        Count <= detail::extent_of<D>::size,
+        "checked_memcpy: count is larger than destination");
+    return std::memcpy(std::data(destination), source, Count);
+  } else {
+    return ::checked_memcpy(
+        std::data(destination),
+        detail::buffer_size(destination),
+        source,
+        Count);
+  }
+}
+
+/**
+ * Copies count bytes from a raw source pointer into destination.
+ */
+template <
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+inline void*
+checked_memcpy(D&& destination, const void* source, std::size_t count) {
+  return ::checked_memcpy(
+      std::data(destination), detail::buffer_size(destination), source, count);
+}
+
+/**
+ * Copies n elements of type T, with sizes given in elements.
+ */
+template <typename T>
+inline T* checked_memcpy_elems(
+    T* destination,
+    std::size_t destination_count,
+    const T* source,
+    std::size_t source_count,
+    std::size_t n) {
+  static_assert(
+      std::is_trivially_copyable_v<T>,
+      "checked_memcpy_elems: element type must be trivially copyable");
+  return static_cast<T*>(::checked_memcpy_elems(
+      destination, destination_count, source, source_count, n, sizeof(T)));
+}
+
+/**
+ * Copies the first n elements of source into destination. Both buffers must
+ * have the same element type.
+ */
+template <
+    typename D,
+    typename S,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_buffer_v<S>,
+        int> = 0>
+inline auto
+checked_memcpy_elems(D&& destination, const S& source, std::size_t n)
+    -> decltype(std::data(destination)) {
+  static_assert(
+      std::is_same_v<
+          std::remove_cv_t<typename detail::buffer_element<D>::type>,
+          std::remove_cv_t<typename detail::buffer_element<S>::type>>,
+      "checked_memcpy_elems: element types differ");
+  return checked_memcpy_elems(
+      std::data(destination),
+      std::size(destination),
+      std::data(source),
+      std::size(source),
+      n);
+}
+
+/**
+ * Copies the whole of source into destination at offset.
+ */
+template <
+    typename D,
+    typename S,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_buffer_v<S>,
+        int> = 0>
+inline void*
+checked_memcpy_offset(D&& destination, std::size_t offset, const S& source) {
+  return ::checked_memcpy_offset(
+      std::data(destination),
+      detail::buffer_size(destination),
+      offset,
+      std::data(source),
+      detail::buffer_size(source));
+}
+
+/**
+ * Copies count bytes from a raw source pointer into destination at offset.
+ */
+template <
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+inline void* checked_memcpy_offset(
+    D&& destination,
+    std::size_t offset,
+    const void* source,
+    std::size_t count) {
+  return ::checked_memcpy_offset(
+      std::data(destination),
+      detail::buffer_size(destination),
+      offset,
+      source,
+      count);
+}
+
+/**
+ * Appends the NUL-terminated source to the string in destination.
+ */
+template <
+    typename D,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_char_buffer_v<D>,
+        int> = 0>
+inline char* checked_strcat(D&& destination, const char* source) {
+  return ::checked_strcat(
+      std::data(destination), detail::buffer_size(destination), source);
+}
+
+/**
+ * Appends source, which need not be NUL-terminated, to the string in
+ * destination.
+ */
+template <
+    typename D,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_char_buffer_v<D>,
+        int> = 0>
+inline char* checked_strcat(D&& destination, std::string_view source) {
+  char* const data = std::data(destination);
+  const std::size_t size = detail::buffer_size(destination);
+  if (size == 0) {
+    buffer_overflow_error_with_size(__func__, size, source.size());
+  }
+  // Room for the terminating NUL is reserved before copying.
+  const std::size_t length = std::strlen(data);
+  ::checked_memcpy_offset(data, size - 1, length, source.data(), source.size());
+  data[length + source.size()] = '\0';
+  return data;
+}
+
+/**
+ * Compares the first num bytes of two buffers.
+ */
+template <
+    typename A,
+    typename B,
+    std::enable_if_t<detail::is_buffer_v<A> && detail::is_buffer_v<B>, int> = 0>
+[[nodiscard]] inline int
+checked_memcmp(const A& ptr1, const B& ptr2, std::size_t num) {
+  return ::checked_memcmp(
+      std::data(ptr1),
+      detail::buffer_size(ptr1),
+      std::data(ptr2),
+      detail::buffer_size(ptr2),
+      num);
+}
+
+/**
+ * Compares the first Num bytes of two buffers, checking Num at compile time
+ * when both sizes are static.
+ */
+template <
+    std::size_t Num,
+    typename A,
+    typename B,
+    std::enable_if_t<detail::is_buffer_v<A> && detail::is_buffer_v<B>, int> = 0>
+[[nodiscard]] inline int checked_memcmp(const A& ptr1, const B& ptr2) {
+  if constexpr (detail::has_static_size_v<A> && detail::has_static_size_v<B>) {
+    static_assert(
+        Num <= detail::extent_of<A>::size && Num <= detail::extent_of<B>::size,
+        "checked_memcmp: num is larger than one of the buffers");
+    return std::memcmp(std::data(ptr1), std::data(ptr2), Num);
+  } else {
+    return ::checked_memcmp(
+        std::data(ptr1),
+        detail::buffer_size(ptr1),
+        std::data(ptr2),
+        detail::buffer_size(ptr2),
+        Num);
+  }
+}
+
+/**
+ * Compares at most count characters of two character buffers.
+ */
+template <
+    typename A,
+    typename B,
+    std::enable_if_t<
+        detail::is_char_buffer_v<A> && detail::is_char_buffer_v<B>,
+        int> = 0>
+inline int checked_strncmp(const A& str1, const B& str2, std::size_t count) {
+  return ::checked_strncmp(
+      std::data(str1),
+      detail::buffer_size(str1),
+      std::data(str2),
+      detail::buffer_size(str2),
+      count);
+}
+
+/**
+ * Fills the whole of destination with ch; no runtime check is needed.
+ */
+template <
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+inline void* checked_memset(D&& destination, int ch) {
+  return std::memset(
+      std::data(destination), ch, detail::buffer_size(destination));
+}
+
+/**
+ * Fills the first count bytes of destination with ch.
+ */
+template <
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+inline void* checked_memset(D&& destination, int ch, std::size_t count) {
+  return ::checked_memset(
+      std::data(destination), detail::buffer_size(destination), ch, count);
+}
+
+namespace detail {
+
+constexpr bool is_constant_evaluated() noexcept {
+#if defined(__cpp_lib_is_constant_evaluated)
+  return std::is_constant_evaluated();
+#elif defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+  return __builtin_is_constant_evaluated();
+#else
+  return true;
+#endif
+#else
+  return true; // Always take the loop that is valid in constant evaluation.
+#endif
+}
+
+template <typename T>
+inline constexpr bool is_byte_v = std::is_same_v<T, char> ||
+    std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char> ||
+    std::is_same_v<T, std::byte>
+#ifdef __cpp_char8_t
+    || std::is_same_v<T, char8_t>
+#endif
+    ;
+
+} // namespace detail
+
+/**
+ * constexpr counterpart of checked_memcpy for arrays of T, with sizes counted
+ * in elements. In constant evaluation it copies element by element and a
+ * failed check is a compile error; at run time it uses memcpy.
+ *
+ * @param destination
+ *      Pointer to the destination where the content is to be copied.
+ * @param destination_count
+ *      Max number of elements to modify in the destination.
+ * @param source
+ *      Pointer to the source of data to be copied.
+ * @param count
+ *      Number of elements to copy.
+ * @return T *
+ *      Pointer to the destination.
+ */
+template <typename T>
+constexpr T* checked_copy(
+    T* destination,
+    std::size_t destination_count,
+    const T* source,
+    std::size_t count) {
+  static_assert(
+      std::is_trivially_copyable_v<T>,
+      "checked_copy requires a trivially copyable type");
+  if (destination_count < count) {
+    buffer_overflow_error_with_size(__func__, destination_count, count);
+  }
+  if (source == nullptr || destination == nullptr) {
+    null_pointer_error(__func__);
+  }
+  if (detail::is_constant_evaluated()) {
+    for (std::size_t i = 0; i < count; ++i) {
+      destination[i] = source[i];
+    }
+    return destination;
+  }
+  std::memcpy(destination, source, count * sizeof(T));
+  return destination;
+}
+
+/**
+ * constexpr counterpart of checked_memcmp for byte-like types, with the same
+ * result convention (bytes compared as unsigned char).
  *
  * @param ptr1
  *      Pointer to block of memory
  * @param ptr1_size
- *      Max number of bytes that can be read from ptr1 (typically the allocated
- * size of the buffer)
+ *      Max number of bytes that can be read from ptr1
  * @param ptr2
  *      Pointer to block of memory
  * @param ptr2_size
- *      Max number of bytes that can be read from ptr2 (typically the allocated
- * size of the buffer)
+ *      Max number of bytes that can be read from ptr2
  * @param num
  *      Number of bytes to compare
  * @return int
- *      Returns an integral value indicating the relationship between the
- * content of the memory blocks.
- *
- * return value < 0: the first byte that does not match in both memory blocks
- * has a lower value in ptr1 than in ptr2 (if evaluated as unsigned char values)
- *
- * return value == 0: the contents of both memory blocks are equal
- *
- * return value > 0: the first byte that does not match in both memory blocks
- * has a greater value in ptr1 than in ptr2 (if evaluated as unsigned char
- * values)
+ *      < 0, 0 or > 0 as memcmp.
  */
-SECURE_LIB_WARN_UNUSED_RESULT static inline int checked_memcmp(
-    const void* ptr1,
-    size_t ptr1_size,
-    const void* ptr2,
-    size_t ptr2_size,
-    size_t num) {
+template <typename T>
+[[nodiscard]] constexpr int checked_compare(
+    const T* ptr1,
+    std::size_t ptr1_size,
+    const T* ptr2,
+    std::size_t ptr2_size,
+    std::size_t num) {
+  static_assert(detail::is_byte_v<T>, "checked_compare requires a byte type");
   if (num > ptr1_size || num > ptr2_size) {
     buffer_oob_read_error(__func__);
   }
-
-  return memcmp(ptr1, ptr2, num);
+  if (detail::is_constant_evaluated()) {
+    for (std::size_t i = 0; i < num; ++i) {
+      const auto lhs = static_cast<unsigned char>(ptr1[i]);
+      const auto rhs = static_cast<unsigned char>(ptr2[i]);
+      if (lhs != rhs) {
+        return lhs < rhs ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+  return std::memcmp(ptr1, ptr2, num);
 }
 
 /**
- * Bounds checking (for both strings) wrapper for std::strncmp.
- * This version aborts the process if there's a possibility of buffer over-read.
+ * constexpr counterpart of checked_strncmp, with the same result convention.
  *
  * @param str1
  *      First string to be compared.
  * @param str1_size
- *      Max number of bytes of the first string (typically the size of the first
- * string).
+ *      Max number of bytes of the first string.
  * @param str2
  *      Second string to be compared.
  * @param str2_size
- *      Max number of bytes of the second string (typically the size of the
- second
- * string).
+ *      Max number of bytes of the second string.
  * @param count
  *      Number of bytes to compare.
  * @return int
- *      1) < 0: the first character that does not match has a lower value in
- str1 than in str2;
- *      2) 0: the contents of both strings are equal;
- *      3) > 0: the first character that does not match has a greater value in
- str1 than in str2.
+ *      < 0, 0 or > 0 as strncmp.
  */
-static inline int checked_strncmp(
+[[nodiscard]] constexpr int checked_string_compare(
     const char* str1,
-    size_t str1_size,
+    std::size_t str1_size,
     const char* str2,
-    size_t str2_size,
-    size_t count) {
+    std::size_t str2_size,
+    std::size_t count) {
   if (str1_size < count || str2_size < count) {
     buffer_oob_read_error(__func__);
   }
+  if (detail::is_constant_evaluated()) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto lhs = static_cast<unsigned char>(str1[i]);
+      const auto rhs = static_cast<unsigned char>(str2[i]);
+      if (lhs != rhs) {
+        return lhs < rhs ? -1 : 1;
+      }
+      if (lhs == '\0') {
+        break;
+      }
+    }
+    return 0;
+  }
+  return std::strncmp(str1, str2, count);
+}
+
+/*
+ * Error-code facade for the try_checked_* family. Each function runs the C
+ * function of the same name and returns the number of bytes written, or the
+ * std::errc matching the C error code (result_out_of_range for
+ * ERR_POTENTIAL_BUFFER_OVERFLOW, value_too_large for
+ * ERR_POTENTIAL_INTEGER_OVERFLOW). result<T> is std::expected<T, std::errc>
+ * when the standard library provides it.
+ */
+#ifdef __cpp_lib_expected
+template <typename T>
+using result = std::expected<T, std::errc>;
+#else
+template <typename T>
+class [[nodiscard]] result {
+ public:
+  using value_type = T;
+  using error_type = std::errc;
+
+  constexpr result(T value) noexcept : value_(value), error_() {}
+
+  static constexpr result failure(std::errc error) noexcept {
+    result failed{T()};
+    failed.error_ = error;
+    return failed;
+  }
+
+  constexpr bool has_value() const noexcept {
+    return error_ == std::errc();
+  }
+  constexpr explicit operator bool() const noexcept {
+    return has_value();
+  }
+  constexpr const T& operator*() const noexcept {
+    return value_;
+  }
+  const T& value() const {
+    if (!has_value()) {
+      error_with_prefix_msg(
+          "safec::result::value",
+          "[err] Aborting due to accessing the value of a failed result in: ");
+    }
+    return value_;
+  }
+  constexpr T value_or(T other) const noexcept {
+    return has_value() ? value_ : other;
+  }
+  constexpr std::errc error() const noexcept {
+    return error_;
+  }
+
+ private:
+  T value_;
+  std::errc error_;
+};
+#endif
 
-  return strncmp(str1, str2, count);
+namespace detail {
+
+constexpr std::errc to_errc(int error) noexcept {
+  switch (error) {
+    case ERR_POTENTIAL_INTEGER_OVERFLOW:
+      return std::errc::value_too_large;
+    case ERR_INVALID_ARGUMENT:
+      return std::errc::invalid_argument;
+    case ERR_OUT_OF_MEMORY:
+      return std::errc::not_enough_memory;
+    case ERR_IO:
+      return std::errc::io_error;
+    default:
+      return std::errc::result_out_of_range;
+  }
+}
+
+template <typename T>
+constexpr result<T> failure(int error) noexcept {
+#ifdef __cpp_lib_expected
+  return std::unexpected(to_errc(error));
+#else
+  return result<T>::failure(to_errc(error));
+#endif
 }
 
+} // namespace detail
+
 /**
- * Bounds checking wrapper for std::memset. This version aborts the process if
- * there's a possibility of writing out-of-bounds.
- *
- * @param destination
- *      Pointer to the destination where the content is to be stored.
- * @param destination_size
- *      Max number of bytes to modify in the destination (typically the size of
- * the destination buffer).
- * @param ch
- *      Byte to fill into the destination.
- * @param count
- *      Number of bytes to store.
- * @return void *
- *      Pointer to the destination.
+ * try_checked_memcpy returning the number of bytes copied.
  */
-static inline void* checked_memset(
+[[nodiscard]] inline result<std::size_t> try_checked_memcpy(
     void* destination,
-    size_t destination_size,
+    std::size_t destination_size,
+    const void* source,
+    std::size_t count) noexcept {
+  const int error =
+      ::try_checked_memcpy(destination, destination_size, source, count);
+  if (error != 0) {
+    return detail::failure<std::size_t>(error);
+  }
+  return count;
+}
+
+/**
+ * try_checked_memcpy_robust returning the number of bytes copied.
+ */
+[[nodiscard]] inline result<std::size_t> try_checked_memcpy_robust(
+    void* destination,
+    std::size_t destination_size,
+    const void* source,
+    std::size_t source_size,
+    std::size_t count) noexcept {
+  const int error = ::try_checked_memcpy_robust(
+      destination, destination_size, source, source_size, count);
+  if (error != 0) {
+    return detail::failure<std::size_t>(error);
+  }
+  return count;
+}
+
+/**
+ * try_checked_memcpy_offset returning the number of bytes copied.
+ */
+[[nodiscard]] inline result<std::size_t> try_checked_memcpy_offset(
+    void* destination,
+    std::size_t destination_size,
+    std::size_t offset,
+    const void* source,
+    std::size_t count) noexcept {
+  const int error = ::try_checked_memcpy_offset(
+      destination, destination_size, offset, source, count);
+  if (error != 0) {
+    return detail::failure<std::size_t>(error);
+  }
+  return count;
+}
+
+/**
+ * try_checked_memset returning the number of bytes set.
+ */
+[[nodiscard]] inline result<std::size_t> try_checked_memset(
+    void* destination,
+    std::size_t destination_size,
     int ch,
-    size_t count) {
-  if (count > destination_size) {
-    buffer_overflow_error(__func__);
+    std::size_t count) noexcept {
+  const int error =
+      ::try_checked_memset(destination, destination_size, ch, count);
+  if (error != 0) {
+    return detail::failure<std::size_t>(error);
+  }
+  return count;
+}
+
+/**
+ * try_checked_memcmp returning the memcmp result.
+ */
+[[nodiscard]] inline result<int> try_checked_memcmp(
+    const void* ptr1,
+    std::size_t ptr1_size,
+    const void* ptr2,
+    std::size_t ptr2_size,
+    std::size_t num) noexcept {
+  int compared = 0;
+  const int error =
+      ::try_checked_memcmp(ptr1, ptr1_size, ptr2, ptr2_size, num, &compared);
+  if (error != 0) {
+    return detail::failure<int>(error);
   }
+  return compared;
+}
 
-  return memset(destination, ch, count);
+/**
+ * try_checked_strncmp returning the strncmp result.
+ */
+[[nodiscard]] inline result<int> try_checked_strncmp(
+    const char* str1,
+    std::size_t str1_size,
+    const char* str2,
+    std::size_t str2_size,
+    std::size_t count) noexcept {
+  int compared = 0;
+  const int error = ::try_checked_strncmp(
+      str1, str1_size, str2, str2_size, count, &compared);
+  if (error != 0) {
+    return detail::failure<int>(error);
+  }
+  return compared;
 }
 
-#undef SECURE_LIB_WARN_UNUSED_RESULT
-#undef FORMAT_PRINTF
+/**
+ * try_checked_strcat returning the number of characters appended, not
+ * counting the terminating NUL.
+ */
+[[nodiscard]] inline result<std::size_t> try_checked_strcat(
+    char* destination,
+    std::size_t destination_size,
+    const char* source) noexcept {
+  // The compiler folds this with the strlen inside the inlined C function.
+  const std::size_t appended = std::strlen(source);
+  const int error = ::try_checked_strcat(destination, destination_size, source);
+  if (error != 0) {
+    return detail::failure<std::size_t>(error);
+  }
+  return appended;
+}
 
-#ifdef __cplusplus
+/**
+ * try_checked_memcpy into a buffer whose size is deduced.
+ */
+template <
+    typename D,
+    std::enable_if_t<detail::is_writable_buffer_v<D>, int> = 0>
+[[nodiscard]] inline result<std::size_t>
+try_checked_memcpy(D&& destination, const void* source, std::size_t count) {
+  return safec::try_checked_memcpy(
+      std::data(destination), detail::buffer_size(destination), source, count);
 }
-#endif
+
+/**
+ * try_checked_strcat into a character buffer whose size is deduced.
+ */
+template <
+    typename D,
+    std::enable_if_t<
+        detail::is_writable_buffer_v<D> && detail::is_char_buffer_v<D>,
+        int> = 0>
+[[nodiscard]] inline result<std::size_t> try_checked_strcat(
+    D&& destination,
+    const char* source) {
+  return safec::try_checked_strcat(
+      std::data(destination), detail::buffer_size(destination), source);
+}
+
+} // namespace safec
+
+#endif // C++17
+#endif // __cplusplus
+
+#undef SECURE_LIB_WARN_UNUSED_RESULT
+#undef FORMAT_PRINTF